@@ -0,0 +1,72 @@
+/*
+    Arena.cpp
+
+    Implement a bump allocator of large reusable chunks
+
+    Allocations are served in order from chunks of CHUNK_SIZE, so each
+    one is a pointer increment. reset() releases them all at once, and
+    the chunks are reused in the same order, so after the first few
+    resets, e.g., of the first units of an archive, no more memory is
+    allocated. An allocation larger than a chunk gets its own block,
+    which is freed by reset(), so one large value does not keep memory
+    for the rest of the run.
+ */
+
+#include "Arena.hpp"
+#include <cstring>
+
+/*
+    Copy of the characters in the arena.
+
+    @param s Characters to copy
+    @return View of the copy, valid until the next reset()
+*/
+std::string_view Arena::copy(std::string_view s) {
+
+    if (s.empty())
+        return std::string_view();
+
+    char* p = allocate(s.size());
+    std::memcpy(p, s.data(), s.size());
+
+    return std::string_view(p, s.size());
+}
+
+/*
+    Allocate from the next chunk, since the current one is full. The
+    rest of the current chunk is not used until the next reset().
+
+    @param size Bytes to allocate
+    @return Pointer to the allocation
+*/
+char* Arena::allocateChunk(std::size_t size) {
+
+    used += size;
+    if (size > CHUNK_SIZE) {
+        large.emplace_back(new char[size]);
+        return large.back().get();
+    }
+
+    // chunks from before the last reset() are reused before adding one
+    if (next != nullptr && current + 1 < chunks.size()) {
+        ++current;
+    } else if (next != nullptr || chunks.empty()) {
+        chunks.emplace_back(new char[CHUNK_SIZE]);
+        current = chunks.size() - 1;
+    }
+    char* p = chunks[current].get();
+    next = p + size;
+    chunkEnd = p + CHUNK_SIZE;
+
+    return p;
+}
+
+// release all allocations
+void Arena::release() {
+
+    large.clear();
+    current = 0;
+    used = 0;
+    next = nullptr;
+    chunkEnd = nullptr;
+}
@@ -0,0 +1,72 @@
+/*
+    Arena.hpp
+
+    Declaration of a bump allocator of large reusable chunks
+*/
+
+#ifndef INCLUDE_ARENA_HPP
+#define INCLUDE_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class Arena {
+public:
+
+    // size of a chunk, and the largest allocation served from the shared chunks
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    // constructor
+    Arena() = default;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // allocate size bytes, valid until the next reset()
+    char* allocate(std::size_t size) {
+
+        if (size > (std::size_t) (chunkEnd - next))
+            return allocateChunk(size);
+
+        char* p = next;
+        next += size;
+        used += size;
+        return p;
+    }
+
+    // copy of the characters, valid until the next reset()
+    std::string_view copy(std::string_view s);
+
+    // release all allocations, keeping the chunks for reuse
+    void reset() {
+
+        if (used != 0)
+            release();
+    }
+
+    // nothing allocated since the last reset()
+    bool empty() const { return used == 0; }
+
+    // bytes allocated since the last reset()
+    std::size_t size() const { return used; }
+
+private:
+    // allocate from the next chunk, adding one if needed
+    char* allocateChunk(std::size_t size);
+
+    // release all allocations
+    void release();
+
+    // chunks of CHUNK_SIZE, kept by reset(), and larger allocations, freed by it
+    std::vector<std::unique_ptr<char[]>> chunks;
+    std::vector<std::unique_ptr<char[]>> large;
+    // index of the chunk in use, and its free space
+    std::size_t current = 0;
+    char* next = nullptr;
+    char* chunkEnd = nullptr;
+    std::size_t used = 0;
+};
+
+#endif
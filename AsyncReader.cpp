@@ -0,0 +1,149 @@
+/*
+    AsyncReader.cpp
+
+    Implement a reader that fills input blocks on its own thread
+
+    The reader thread reads into a ring of fixed-size blocks while the
+    parser works on earlier ones. Blocks are handed over through two
+    lock-free queues: free blocks to the reader, filled blocks to the
+    parser.
+
+    A token may straddle two blocks. Each block has headroom in front
+    of its data, and on refill the unprocessed characters of the old
+    block are copied into the headroom of the new block, just before
+    its data, so the parser always sees one contiguous range.
+
+    The reader thread checks for a stop only between calls to the
+    source. A call that blocks, e.g., a read of a pipe with no data
+    yet, is not interrupted, so destroying the reader waits for it to
+    return with data or at the end of input.
+ */
+
+#include "AsyncReader.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// wait for the other thread, spinning briefly before sleeping
+void backoff(int& spins) {
+
+    if (++spins < 64)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+}
+
+}
+
+// constructor, starts the reader thread reading the source, e.g., a decompressor
+AsyncReader::AsyncReader(Source source)
+    : source(std::move(source)), blocks(new char[BLOCK_COUNT * 2 * BLOCK_SIZE])
+{
+    for (int i = 0; i < BLOCK_COUNT; ++i)
+        freeBlocks.push(i);
+
+    reader = std::thread(&AsyncReader::readBlocks, this);
+}
+
+/*
+    Stop the reader thread. The thread stops before its next call to
+    the source, so this waits for a call in progress to return, e.g.,
+    for a read of a pipe to get data or the end of input.
+*/
+AsyncReader::~AsyncReader() {
+
+    stop = true;
+    reader.join();
+}
+
+/*
+    Fill free blocks from the source until end of input.
+    An empty block marks the end of input.
+*/
+void AsyncReader::readBlocks() {
+
+    bool eof = false;
+    while (!stop) {
+
+        int block;
+        int spins = 0;
+        while (!freeBlocks.pop(block)) {
+            if (stop)
+                return;
+            backoff(spins);
+        }
+
+        // fill the whole block, since a pipe or decompressor returns less per read
+        char* data = blocks.get() + (std::size_t) block * 2 * BLOCK_SIZE + BLOCK_SIZE;
+        long length = 0;
+        while (!eof && length < (long) BLOCK_SIZE) {
+            const long numbytes = source(data + length, (long) BLOCK_SIZE - length);
+            if (numbytes <= 0) {
+                eof = true;
+                break;
+            }
+            length += (long) numbytes;
+        }
+
+        spins = 0;
+        while (!filledBlocks.push(Filled{ block, length }))
+            backoff(spins);
+
+        if (length == 0)
+            return;
+    }
+}
+
+/*
+    Move to the next filled block. Characters [pc, end) of the current
+    block are carried over in front of the new data. At the end of
+    input, the current block and [pc, end) are left as they are.
+
+    @param pc Current position, updated to the start of the carried-over characters
+    @param end End of the data, updated to the end of the new block
+    @param totalBytes Updated total bytes read
+    @return false at the end of input
+*/
+bool AsyncReader::refill(const char*& pc, const char*& end, long& totalBytes) {
+
+    // EOF
+    if (done)
+        return false;
+
+    Filled filled;
+    int spins = 0;
+    while (!filledBlocks.pop(filled))
+        backoff(spins);
+
+    // EOF
+    if (filled.length == 0) {
+        done = true;
+        freeBlocks.push(filled.block);
+        return false;
+    }
+
+    // carry over unprocessed characters into the headroom
+    const std::size_t leftover = (std::size_t) std::distance(pc, end);
+    if (leftover > BLOCK_SIZE) {
+        std::cerr << "parser error : Token larger than input block\n";
+        exit(1);
+    }
+    char* data = blocks.get() + (std::size_t) filled.block * 2 * BLOCK_SIZE + BLOCK_SIZE;
+    if (leftover)
+        std::memcpy(data - leftover, pc, leftover);
+
+    // the old block can now be refilled
+    if (current != -1)
+        freeBlocks.push(current);
+    current = filled.block;
+
+    pc = data - leftover;
+    end = data + filled.length;
+    totalBytes += filled.length;
+
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+    AsyncReader.hpp
+
+    Declaration of a reader that fills input blocks on its own thread
+*/
+
+#ifndef INCLUDE_ASYNCREADER_HPP
+#define INCLUDE_ASYNCREADER_HPP
+
+#include "SPSCQueue.hpp"
+#include "refillBuffer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+
+class AsyncReader {
+public:
+
+    // source of input, reading up to size bytes into data, returning 0 at end of input
+    using Source = std::function<long(char* data, long size)>;
+
+    // constructor, starts the reader thread reading the source, e.g., a decompressor
+    explicit AsyncReader(Source source);
+
+    // destructor, stops the reader thread once a read of the source in progress returns
+    ~AsyncReader();
+
+    AsyncReader(const AsyncReader&) = delete;
+    AsyncReader& operator=(const AsyncReader&) = delete;
+
+    // move to the next block, keeping the unprocessed characters [pc, end), returning false at end of input
+    bool refill(const char*& pc, const char*& end, long& totalBytes);
+
+private:
+    // fill free blocks until end of input (reader thread)
+    void readBlocks();
+
+    // a filled block
+    struct Filled {
+        int block;
+        long length;
+    };
+
+    static constexpr int BLOCK_COUNT = 4;
+    static constexpr std::size_t BLOCK_SIZE = BUFFER_SIZE;
+
+    Source source;
+    // each block is BLOCK_SIZE of headroom for carried-over characters followed by BLOCK_SIZE of data
+    std::unique_ptr<char[]> blocks;
+    SPSCQueue<int, BLOCK_COUNT> freeBlocks;
+    SPSCQueue<Filled, BLOCK_COUNT> filledBlocks;
+    int current = -1;
+    bool done = false;
+    std::atomic<bool> stop{false};
+    std::thread reader;
+};
+
+#endif
@@ -0,0 +1,220 @@
+/*
+    Checkpoint.cpp
+
+    Implement a checkpoint of a parse, for resuming at a tag boundary
+
+    A checkpoint is a small text file, one item per line:
+
+        checkpoint 1
+        offset 1048576
+        depth 1
+        intag 0
+        anchor 1040211 153 9f3a61c2e45d0b17
+        element unit
+        namespace http://www.srcML.org/srcML/src
+        namespace http://www.srcML.org/srcML/cpp cpp
+        counter loc 20418
+        value url project
+
+    The anchor is the hash of a tag before the offset. On resume it is
+    checked against the input file, so a checkpoint is only used with
+    the input it was taken from, or with that input extended, e.g.,
+    an archive with more units appended. The file is written to a
+    temporary file and renamed, so a parse killed while writing a
+    checkpoint leaves the previous one.
+ */
+
+#include "Checkpoint.hpp"
+#include "mapInput.hpp"
+#include "fnvHash.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#else
+#include <io.h>
+#endif
+
+namespace {
+
+const char* const CHECKPOINT_VERSION = "checkpoint 1";
+
+// escape backslashes and line breaks so a value fits on one line
+std::string escapeValue(std::string_view value) {
+
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\')
+            escaped += "\\\\";
+        else if (c == '\n')
+            escaped += "\\n";
+        else if (c == '\r')
+            escaped += "\\r";
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+// undo escapeValue()
+std::string unescapeValue(std::string_view value) {
+
+    std::string unescaped;
+    unescaped.reserve(value.size());
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        if (value[i] == '\\' && i + 1 < value.size()) {
+            ++i;
+            unescaped += value[i] == 'n' ? '\n' : value[i] == 'r' ? '\r' : value[i];
+        } else {
+            unescaped += value[i];
+        }
+    }
+    return unescaped;
+}
+
+}
+
+/*
+    Set the anchor to a tag before the offset.
+
+    @param tagOffset Offset of the tag in the input
+    @param tag Text of the tag
+*/
+void Checkpoint::setAnchor(long tagOffset, std::string_view tag) {
+
+    anchorOffset = tagOffset;
+    anchorLength = (long) tag.size();
+    anchorHash = fnvHash64(tag);
+}
+
+/*
+    Write the checkpoint to a temporary file, and rename it to the path.
+
+    @param path Path of the checkpoint file
+    @return false if the file could not be written
+*/
+bool Checkpoint::save(const std::string& path) const {
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out << CHECKPOINT_VERSION << '\n';
+        out << "offset " << offset << '\n';
+        out << "depth " << depth << '\n';
+        out << "intag " << (intag ? 1 : 0) << '\n';
+        out << "anchor " << anchorOffset << ' ' << anchorLength << ' ' << std::hex << anchorHash << std::dec << '\n';
+        for (const auto& element : elements)
+            out << "element " << element << '\n';
+        for (const auto& ns : namespaces) {
+            out << "namespace " << ns.second;
+            if (!ns.first.empty())
+                out << ' ' << ns.first;
+            out << '\n';
+        }
+        for (const auto& counter : counters)
+            out << "counter " << counter.first << ' ' << counter.second << '\n';
+        for (const auto& value : values)
+            out << "value " << value.first << ' ' << escapeValue(value.second) << '\n';
+        out.flush();
+        if (!out)
+            return false;
+    }
+
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+/*
+    Read a checkpoint file.
+
+    @param path Path of the checkpoint file
+    @return false if the file is missing, or is not a checkpoint
+*/
+bool Checkpoint::load(const std::string& path) {
+
+    std::ifstream in(path, std::ios::binary);
+    std::string line;
+    if (!std::getline(in, line) || line != CHECKPOINT_VERSION)
+        return false;
+
+    *this = Checkpoint();
+    bool hasOffset = false;
+    while (std::getline(in, line)) {
+        const auto space = line.find(' ');
+        const std::string key = line.substr(0, space);
+        const std::string rest = space == std::string::npos ? std::string() : line.substr(space + 1);
+        std::istringstream fields(rest);
+        if (key == "offset") {
+            hasOffset = (bool) (fields >> offset);
+        } else if (key == "depth") {
+            fields >> depth;
+        } else if (key == "intag") {
+            int flag = 0;
+            fields >> flag;
+            intag = flag != 0;
+        } else if (key == "anchor") {
+            fields >> anchorOffset >> anchorLength >> std::hex >> anchorHash;
+        } else if (key == "element") {
+            elements.push_back(rest);
+        } else if (key == "namespace") {
+            const auto prefixStart = rest.find(' ');
+            if (prefixStart == std::string::npos)
+                namespaces.emplace_back(std::string(), rest);
+            else
+                namespaces.emplace_back(rest.substr(prefixStart + 1), rest.substr(0, prefixStart));
+        } else if (key == "counter") {
+            std::string name;
+            long count = 0;
+            if (fields >> name >> count)
+                counters.emplace_back(name, count);
+        } else if (key == "value") {
+            const auto valueStart = rest.find(' ');
+            values.emplace_back(rest.substr(0, valueStart),
+                valueStart == std::string::npos ? std::string() : unescapeValue(std::string_view(rest).substr(valueStart + 1)));
+        } else {
+            return false;
+        }
+        if (!fields && key != "element" && key != "namespace" && key != "value")
+            return false;
+    }
+
+    return hasOffset && depth == (int) elements.size();
+}
+
+/*
+    Check that the input file has the anchor tag, and seek to the
+    offset of the checkpoint.
+
+    @param fd File descriptor of the input, a regular file
+    @return false if the input cannot seek, or does not match the checkpoint
+*/
+bool Checkpoint::seekInput(int fd) const {
+
+    std::string tag((std::size_t) anchorLength, '\0');
+    if (anchorLength > 0 && (!readInputAt(fd, tag.data(), anchorLength, anchorOffset) || fnvHash64(tag) != anchorHash))
+        return false;
+
+#if !defined(_MSC_VER)
+    return lseek(fd, (off_t) offset, SEEK_SET) == (off_t) offset;
+#else
+    return _lseeki64(fd, offset, SEEK_SET) == offset;
+#endif
+}
+
+/*
+    Value of a counter.
+
+    @param name Name of the counter
+    @return The value, or 0 if there is no counter with the name
+*/
+long Checkpoint::counter(std::string_view name) const {
+
+    for (const auto& counter : counters) {
+        if (counter.first == name)
+            return counter.second;
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+    Checkpoint.hpp
+
+    Declaration of a checkpoint of a parse, for resuming at a tag boundary
+*/
+
+#ifndef INCLUDE_CHECKPOINT_HPP
+#define INCLUDE_CHECKPOINT_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct Checkpoint {
+
+    // offset of the input to resume at, the start of a tag
+    long offset = 0;
+    // parser state before that tag
+    int depth = 0;
+    bool intag = false;
+    // qualified names of the open elements, outermost first
+    std::vector<std::string> elements;
+    // namespace declarations in scope, as prefix and URI
+    std::vector<std::pair<std::string, std::string>> namespaces;
+    // partial counts, and other values, of the handlers
+    std::vector<std::pair<std::string, long>> counters;
+    std::vector<std::pair<std::string, std::string>> values;
+
+    // a tag before the offset, used to check that the input matches
+    long anchorOffset = 0;
+    long anchorLength = 0;
+    std::uint64_t anchorHash = 0;
+
+    // set the anchor to a tag at an offset
+    void setAnchor(long tagOffset, std::string_view tag);
+
+    // write the checkpoint, replacing the file atomically
+    bool save(const std::string& path) const;
+
+    // read a checkpoint, returning false if the file is missing or invalid
+    bool load(const std::string& path);
+
+    // check the anchor in the input file, and seek to the offset
+    bool seekInput(int fd) const;
+
+    // value of a counter, or 0 if there is none
+    long counter(std::string_view name) const;
+};
+
+#endif
@@ -0,0 +1,344 @@
+/*
+    Decompressor.cpp
+
+    Implement a streaming decompressor for compressed srcML input
+
+    The format is detected from the signature in the first bytes:
+
+    * gzip, including concatenated members, with zlib
+    * zip, the first entry only, stored or deflated, with zlib
+    * zstd, including concatenated frames, with libzstd
+
+    Each library is optional at build time (SRCFACTS_ZLIB and
+    SRCFACTS_ZSTD). Input in a format whose library is not in the
+    build is an error.
+
+    Compressed input is read from a file descriptor into a buffer,
+    or taken directly from memory, e.g., a mapped file. Decompressed
+    data goes directly into the caller's block, with no further copy.
+ */
+
+#include "Decompressor.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <errno.h>
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#define READ ::read
+#else
+#include <BaseTsd.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#define READ ::_read
+#endif
+#if defined(SRCFACTS_ZLIB)
+#include <zlib.h>
+#endif
+#if defined(SRCFACTS_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace {
+
+const std::size_t INPUT_SIZE = 256 * 1024;
+
+// report the error and stop
+[[noreturn]] void decompressError(const char* message) {
+
+    std::cerr << "parser error : " << message << '\n';
+    exit(1);
+}
+
+// little-endian 16-bit value
+unsigned int get16(const unsigned char* p) {
+
+    return (unsigned int) p[0] | ((unsigned int) p[1] << 8);
+}
+
+// little-endian 32-bit value
+std::uint32_t get32(const unsigned char* p) {
+
+    return (std::uint32_t) get16(p) | ((std::uint32_t) get16(p + 2) << 16);
+}
+
+// little-endian 64-bit value
+std::uint64_t get64(const unsigned char* p) {
+
+    return (std::uint64_t) get32(p) | ((std::uint64_t) get32(p + 4) << 32);
+}
+
+}
+
+// decompression library state
+struct Decompressor::Stream {
+#if defined(SRCFACTS_ZLIB)
+    z_stream zlib{};
+    bool zlibStarted = false;
+#endif
+#if defined(SRCFACTS_ZSTD)
+    ZSTD_DStream* zstd = nullptr;
+#endif
+
+    ~Stream() {
+#if defined(SRCFACTS_ZLIB)
+        if (zlibStarted)
+            inflateEnd(&zlib);
+#endif
+#if defined(SRCFACTS_ZSTD)
+        if (zstd)
+            ZSTD_freeDStream(zstd);
+#endif
+    }
+};
+
+/*
+    Format of input from its first bytes.
+
+    @param begin Start of the input
+    @param end End of the available input
+    @return Format of the input, NONE if not a known compressed format
+*/
+Decompressor::Format Decompressor::format(const char* begin, const char* end) {
+
+    const auto length = std::distance(begin, end);
+    const unsigned char* p = (const unsigned char*) begin;
+    if (length >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+        return GZIP;
+    if (length >= 4 && p[0] == 'P' && p[1] == 'K' && p[2] == 3 && p[3] == 4)
+        return ZIP;
+    if (length >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd)
+        return ZSTD;
+
+    return NONE;
+}
+
+/*
+    Constructor over a file descriptor. The bytes already read, e.g.,
+    to detect the format, are decompressed before any further input.
+
+    @param fd File descriptor of the rest of the compressed input
+    @param begin Start of the bytes already read
+    @param end End of the bytes already read
+*/
+Decompressor::Decompressor(int fd, const char* begin, const char* end)
+    : inputFormat(format(begin, end)), fd(fd), input(begin, end), stream(new Stream)
+{
+    const std::size_t length = input.size();
+    input.resize(std::max(length, INPUT_SIZE));
+    next = input.data();
+    last = next + length;
+
+    start();
+}
+
+/*
+    Constructor over compressed input in memory. The memory must stay
+    valid until decompression is done.
+
+    @param begin Start of the compressed input
+    @param end End of the compressed input
+*/
+Decompressor::Decompressor(const char* begin, const char* end)
+    : inputFormat(format(begin, end)), next(begin), last(end), stream(new Stream)
+{
+    start();
+}
+
+// destructor
+Decompressor::~Decompressor() = default;
+
+// set up decompression for the input format
+void Decompressor::start() {
+
+    switch (inputFormat) {
+    case NONE:
+        decompressError("Unknown compressed input format");
+
+    case GZIP:
+    case ZIP:
+#if defined(SRCFACTS_ZLIB)
+        if (inputFormat == ZIP) {
+            readZipHeader();
+            if (stored)
+                return;
+        }
+        // gzip wrapper, or raw deflate for a zip entry
+        if (inflateInit2(&stream->zlib, inputFormat == GZIP ? 15 + 16 : -15) != Z_OK)
+            decompressError("Cannot start decompression");
+        stream->zlibStarted = true;
+        return;
+#else
+        decompressError("Compressed input needs zlib, which is not in this build");
+#endif
+
+    case ZSTD:
+#if defined(SRCFACTS_ZSTD)
+        stream->zstd = ZSTD_createDStream();
+        if (!stream->zstd || ZSTD_isError(ZSTD_initDStream(stream->zstd)))
+            decompressError("Cannot start decompression");
+        return;
+#else
+        decompressError("zstd input needs libzstd, which is not in this build");
+#endif
+    }
+}
+
+/*
+    Make at least count compressed bytes available in [next, last),
+    reading more from the file descriptor if needed.
+
+    @param count Number of bytes needed
+    @return true if count bytes are available, false at the end of input
+*/
+bool Decompressor::need(std::size_t count) {
+
+    if ((std::size_t) std::distance(next, last) >= count)
+        return true;
+
+    // all of the input is in memory
+    if (fd == -1)
+        return false;
+
+    // move the unused bytes to the start of the buffer, and read after them
+    const std::size_t unused = (std::size_t) std::distance(next, last);
+    std::memmove(&input[0], next, unused);
+    if (input.size() < count)
+        input.resize(count);
+    std::size_t length = unused;
+    while (length < count) {
+        const ssize_t numbytes = READ(fd, (void*) (input.data() + length), (size_t) (input.size() - length));
+        if (numbytes == -1 && errno == EINTR)
+            continue;
+        if (numbytes <= 0)
+            break;
+        length += (std::size_t) numbytes;
+    }
+    next = input.data();
+    last = next + length;
+
+    return length >= count;
+}
+
+/*
+    Skip the zip local file header of the first entry, leaving the
+    input at the entry data. A stored entry is copied as is, so its
+    size is taken from the header, or from the zip64 extra field.
+*/
+void Decompressor::readZipHeader() {
+
+    const std::size_t HEADER_SIZE = 30;
+    if (!need(HEADER_SIZE))
+        decompressError("Incomplete zip header");
+    const unsigned char* header = (const unsigned char*) next;
+    const unsigned int flags = get16(header + 6);
+    const unsigned int method = get16(header + 8);
+    std::uint64_t compressedSize = get32(header + 18);
+    const std::size_t nameLength = get16(header + 26);
+    const std::size_t extraLength = get16(header + 28);
+
+    if (!need(HEADER_SIZE + nameLength + extraLength))
+        decompressError("Incomplete zip header");
+    header = (const unsigned char*) next;
+
+    // zip64 sizes are in the extra field, uncompressed size first
+    if (compressedSize == 0xFFFFFFFF) {
+        const unsigned char* extra = header + HEADER_SIZE + nameLength;
+        const unsigned char* extraEnd = extra + extraLength;
+        while (std::distance(extra, extraEnd) >= 4) {
+            const unsigned int id = get16(extra);
+            const unsigned int length = get16(extra + 2);
+            if (id == 0x0001 && length >= 16)
+                compressedSize = get64(extra + 4 + 8);
+            extra += 4 + length;
+        }
+    }
+    std::advance(next, HEADER_SIZE + nameLength + extraLength);
+
+    if (flags & 0x1)
+        decompressError("Encrypted zip entries are not supported");
+
+    if (method == 0) {
+        // without sizes in the header, the end of a stored entry is unknown
+        if (flags & 0x8)
+            decompressError("Stored zip entry without sizes is not supported");
+        stored = true;
+        storedRemaining = (long) compressedSize;
+        done = storedRemaining == 0;
+    } else if (method != 8) {
+        decompressError("Unsupported zip compression method");
+    }
+}
+
+/*
+    Decompress into data. Blocks until at least one byte is produced
+    or the input ends.
+
+    @param data Destination of the decompressed bytes
+    @param size Maximum number of bytes
+    @return Number of decompressed bytes, 0 at the end of input
+*/
+long Decompressor::read(char* data, long size) {
+
+    long produced = 0;
+    while (produced == 0 && !done) {
+
+        // at the end of input, the library may still have output pending
+        const bool moreInput = next != last || need(1);
+
+        // stored zip entry
+        if (stored) {
+            const long count = std::min({ storedRemaining, (long) std::distance(next, last), size });
+            std::memcpy(data, next, (std::size_t) count);
+            std::advance(next, count);
+            storedRemaining -= count;
+            produced = count;
+            done = storedRemaining == 0;
+        }
+
+#if defined(SRCFACTS_ZLIB)
+        if (!stored && (inputFormat == GZIP || inputFormat == ZIP)) {
+            z_stream& zlib = stream->zlib;
+            zlib.next_in = (Bytef*) next;
+            zlib.avail_in = (uInt) std::min<std::ptrdiff_t>(std::distance(next, last), UINT_MAX);
+            zlib.next_out = (Bytef*) data;
+            zlib.avail_out = (uInt) std::min<long>(size, UINT_MAX);
+            const int status = inflate(&zlib, Z_NO_FLUSH);
+            if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR)
+                decompressError("Invalid compressed input");
+            next = (const char*) zlib.next_in;
+            produced = size - (long) zlib.avail_out;
+            if (status == Z_STREAM_END) {
+                // concatenated gzip members continue the input
+                if (inputFormat == GZIP && need(2) && (unsigned char) next[0] == 0x1f && (unsigned char) next[1] == 0x8b)
+                    inflateReset(&zlib);
+                else
+                    done = true;
+            }
+        }
+#endif
+
+#if defined(SRCFACTS_ZSTD)
+        if (inputFormat == ZSTD) {
+            ZSTD_inBuffer in = { next, (std::size_t) std::distance(next, last), 0 };
+            ZSTD_outBuffer out = { data, (std::size_t) size, 0 };
+            const std::size_t status = ZSTD_decompressStream(stream->zstd, &out, &in);
+            if (ZSTD_isError(status))
+                decompressError("Invalid compressed input");
+            std::advance(next, in.pos);
+            produced = (long) out.pos;
+            // a complete frame with no more input is the end, otherwise another frame follows
+            if (status == 0 && next == last && !need(1))
+                done = true;
+        }
+#endif
+
+        if (produced == 0 && !done && !moreInput)
+            decompressError("Truncated compressed input");
+    }
+
+    return produced;
+}
@@ -0,0 +1,63 @@
+/*
+    Decompressor.hpp
+
+    Declaration of a streaming decompressor for compressed srcML input
+*/
+
+#ifndef INCLUDE_DECOMPRESSOR_HPP
+#define INCLUDE_DECOMPRESSOR_HPP
+
+#include <memory>
+#include <string>
+
+class Decompressor {
+public:
+
+    // formats of input
+    enum Format { NONE, GZIP, ZIP, ZSTD };
+
+    // format of input from its first bytes
+    static Format format(const char* begin, const char* end);
+
+    // constructor over a file descriptor, with the first bytes [begin, end) already read from it
+    Decompressor(int fd, const char* begin, const char* end);
+
+    // constructor over compressed input in memory
+    Decompressor(const char* begin, const char* end);
+
+    // destructor
+    ~Decompressor();
+
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    // decompress up to size bytes into data, returning 0 at the end of input
+    long read(char* data, long size);
+
+private:
+    // set up decompression for the input format
+    void start();
+
+    // make at least count compressed bytes available, if there are that many
+    bool need(std::size_t count);
+
+    // skip the zip local file header of the first entry
+    void readZipHeader();
+
+    // decompression library state
+    struct Stream;
+
+    Format inputFormat;
+    int fd = -1;
+    // compressed input read from the file descriptor
+    std::string input;
+    const char* next = nullptr;
+    const char* last = nullptr;
+    std::unique_ptr<Stream> stream;
+    // bytes left in a stored (uncompressed) zip entry
+    long storedRemaining = 0;
+    bool stored = false;
+    bool done = false;
+};
+
+#endif
@@ -0,0 +1,66 @@
+/*
+    ElementNames.cpp
+
+    Implement a table of element name IDs
+
+    Names in the srcML vocabulary have fixed IDs from the perfect hash.
+    Other names are interned in an open-addressing table on first use
+    and get IDs from ELEMENT_COUNT on. Interned IDs are per table, so
+    they are only comparable between events of the same parser.
+ */
+
+#include "ElementNames.hpp"
+
+namespace {
+
+const std::size_t INITIAL_SLOTS = 64;
+
+}
+
+// local name of the element ID
+std::string_view ElementNames::name(ElementID id) const {
+
+    if (id < ELEMENT_COUNT)
+        return SRCML_ELEMENT_NAMES[id];
+
+    return names[id - ELEMENT_COUNT];
+}
+
+// number of IDs, known and interned
+int ElementNames::size() const {
+
+    return ELEMENT_COUNT + (int) names.size();
+}
+
+/*
+    ID of a name not in the srcML vocabulary. A new name is copied
+    into the table, so only the first occurrence allocates.
+
+    @param local_name Element local name
+    @return ID of the name
+*/
+ElementID ElementNames::intern(std::string_view local_name) {
+
+    // grow at half full, rehashing the interned names
+    if (names.size() * 2 >= slots.size()) {
+        slots.assign(slots.empty() ? INITIAL_SLOTS : slots.size() * 2, -1);
+        for (int i = 0; i < (int) names.size(); ++i) {
+            std::size_t slot = fnvHash32(names[i]) & (slots.size() - 1);
+            while (slots[slot] != -1)
+                slot = (slot + 1) & (slots.size() - 1);
+            slots[slot] = i;
+        }
+    }
+
+    std::size_t slot = fnvHash32(local_name) & (slots.size() - 1);
+    while (slots[slot] != -1) {
+        if (names[slots[slot]] == local_name)
+            return (ElementID) (ELEMENT_COUNT + slots[slot]);
+        slot = (slot + 1) & (slots.size() - 1);
+    }
+
+    slots[slot] = (int) names.size();
+    names.emplace_back(local_name);
+
+    return (ElementID) (ELEMENT_COUNT + slots[slot]);
+}
@@ -0,0 +1,43 @@
+/*
+    ElementNames.hpp
+
+    Declaration of a table of element name IDs
+*/
+
+#ifndef INCLUDE_ELEMENTNAMES_HPP
+#define INCLUDE_ELEMENTNAMES_HPP
+
+#include "srcMLElements.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ElementNames {
+public:
+
+    // ID of the element local name, interning names not in the srcML vocabulary
+    ElementID id(std::string_view local_name) {
+
+        const int known = knownElementID(local_name);
+        if (known != -1)
+            return (ElementID) known;
+
+        return intern(local_name);
+    }
+
+    // local name of the element ID
+    std::string_view name(ElementID id) const;
+
+    // number of IDs, known and interned
+    int size() const;
+
+private:
+    // ID of a name not in the srcML vocabulary
+    ElementID intern(std::string_view local_name);
+
+    // open-addressing table of interned name indexes, with -1 for an empty slot
+    std::vector<int> slots;
+    std::vector<std::string> names;
+};
+
+#endif
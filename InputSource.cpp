@@ -0,0 +1,156 @@
+/*
+    InputSource.cpp
+
+    Implement a source of XML input
+
+    A source only says where the input is. The parser decides how to
+    read it: a file descriptor of a regular file is mapped, and others
+    read into the buffer, or by a reader thread. Memory is parsed in
+    place. A callback is read like a file descriptor.
+ */
+
+#include "InputSource.hpp"
+#include <utility>
+#include <errno.h>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <unistd.h>
+#define READ ::read
+#define OPEN ::open
+#define CLOSE ::close
+#define OPEN_FLAGS O_RDONLY
+#else
+#include <BaseTsd.h>
+#include <fcntl.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#define READ ::_read
+#define OPEN ::_open
+#define CLOSE ::_close
+#define OPEN_FLAGS (_O_RDONLY | _O_BINARY)
+#endif
+
+// constructor of a kind of source
+InputSource::InputSource(Kind kind)
+    : sourceKind(kind)
+{}
+
+// open file descriptor, e.g., 0 for standard input, left open
+InputSource InputSource::fromFD(int fd) {
+
+    InputSource source(FD);
+    source.fileDescriptor = fd;
+
+    return source;
+}
+
+/*
+    File opened by path. A file that cannot be opened is a source that
+    is not open, and the parser reports it.
+
+    @param path Path of the file
+    @return Source of the file, closed when the source is destroyed
+*/
+InputSource InputSource::fromPath(const std::string& path) {
+
+    InputSource source(FD);
+    source.fileDescriptor = OPEN(path.c_str(), OPEN_FLAGS);
+    source.ownsFD = source.fileDescriptor != -1;
+
+    return source;
+}
+
+// input in memory, which must stay valid during the parse
+InputSource InputSource::fromMemory(const char* begin, const char* end) {
+
+    InputSource source(MEMORY);
+    source.memoryBegin = begin;
+    source.memoryEnd = end;
+
+    return source;
+}
+
+// input in memory, which must stay valid during the parse
+InputSource InputSource::fromMemory(std::string_view input) {
+
+    return fromMemory(input.data(), input.data() + input.size());
+}
+
+// input from a callback
+InputSource InputSource::fromCallback(Callback callback) {
+
+    InputSource source(CALLBACK);
+    source.callback = std::move(callback);
+
+    return source;
+}
+
+// destructor, closing a file opened by path
+InputSource::~InputSource() {
+
+    close();
+}
+
+// move constructor, taking over any file opened by path
+InputSource::InputSource(InputSource&& other) noexcept
+    : sourceKind(other.sourceKind), fileDescriptor(other.fileDescriptor), ownsFD(other.ownsFD),
+      memoryBegin(other.memoryBegin), memoryEnd(other.memoryEnd), callback(std::move(other.callback))
+{
+    other.ownsFD = false;
+}
+
+// move assignment, closing any file of this source opened by path
+InputSource& InputSource::operator=(InputSource&& other) noexcept {
+
+    if (this == &other)
+        return *this;
+
+    close();
+    sourceKind = other.sourceKind;
+    fileDescriptor = other.fileDescriptor;
+    ownsFD = other.ownsFD;
+    memoryBegin = other.memoryBegin;
+    memoryEnd = other.memoryEnd;
+    callback = std::move(other.callback);
+    other.ownsFD = false;
+
+    return *this;
+}
+
+// source can be read, i.e., not a path that could not be opened
+bool InputSource::isOpen() const {
+
+    return sourceKind != FD || fileDescriptor != -1;
+}
+
+/*
+    Read from a file or callback. Memory is not read, since it is
+    parsed in place.
+
+    @param data Where to read to
+    @param size Most bytes to read
+    @return Number of bytes read, 0 at the end of input or on an error
+*/
+long InputSource::read(char* data, long size) {
+
+    if (sourceKind == CALLBACK)
+        return callback(data, size);
+
+    if (sourceKind != FD || fileDescriptor == -1)
+        return 0;
+
+    ssize_t numbytes;
+    while ((numbytes = READ(fileDescriptor, (void*) data, (size_t) size)) == -1 && errno == EINTR) {
+    }
+
+    return numbytes < 0 ? 0 : (long) numbytes;
+}
+
+// close a file opened by path
+void InputSource::close() {
+
+    if (ownsFD)
+        CLOSE(fileDescriptor);
+    ownsFD = false;
+    fileDescriptor = -1;
+}
@@ -0,0 +1,81 @@
+/*
+    InputSource.hpp
+
+    Declaration of a source of XML input: a file descriptor, a file path,
+    memory, or a callback
+*/
+
+#ifndef INCLUDE_INPUTSOURCE_HPP
+#define INCLUDE_INPUTSOURCE_HPP
+
+#include <functional>
+#include <string>
+#include <string_view>
+
+class InputSource {
+public:
+
+    // reads up to size bytes into data, returning 0 at the end of input
+    using Callback = std::function<long(char* data, long size)>;
+
+    // kinds of sources
+    enum Kind { FD, MEMORY, CALLBACK };
+
+    // open file descriptor, e.g., 0 for standard input, left open
+    static InputSource fromFD(int fd);
+
+    // file opened by path, and closed with the source
+    static InputSource fromPath(const std::string& path);
+
+    // input in memory, which must stay valid during the parse
+    static InputSource fromMemory(const char* begin, const char* end);
+
+    // input in memory, which must stay valid during the parse
+    static InputSource fromMemory(std::string_view input);
+
+    // input from a callback
+    static InputSource fromCallback(Callback callback);
+
+    // destructor, closing a file opened by path
+    ~InputSource();
+
+    InputSource(InputSource&& other) noexcept;
+    InputSource& operator=(InputSource&& other) noexcept;
+
+    InputSource(const InputSource&) = delete;
+    InputSource& operator=(const InputSource&) = delete;
+
+    // kind of source
+    Kind kind() const { return sourceKind; }
+
+    // file descriptor, or -1 if not a file, or a path that could not be opened
+    int fd() const { return fileDescriptor; }
+
+    // start of input in memory
+    const char* begin() const { return memoryBegin; }
+
+    // end of input in memory
+    const char* end() const { return memoryEnd; }
+
+    // source can be read, i.e., not a path that could not be opened
+    bool isOpen() const;
+
+    // read up to size bytes into data, from a file or callback, returning 0 at the end of input or on an error
+    long read(char* data, long size);
+
+private:
+    // constructor of a kind of source
+    explicit InputSource(Kind kind);
+
+    // close a file opened by path
+    void close();
+
+    Kind sourceKind;
+    int fileDescriptor = -1;
+    bool ownsFD = false;
+    const char* memoryBegin = nullptr;
+    const char* memoryEnd = nullptr;
+    Callback callback;
+};
+
+#endif
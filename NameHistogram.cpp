@@ -0,0 +1,98 @@
+/*
+    NameHistogram.cpp
+
+    Implement a histogram of names in an open-addressing flat hash map
+
+    Entries are stored inline in one table with linear probing, and
+    each name is copied once into a single names buffer, so counting
+    an existing name does no allocation. The table doubles at half
+    full. Entries refer to names by offset, so growing the names
+    buffer does not invalidate them.
+ */
+
+#include "NameHistogram.hpp"
+#include "fnvHash.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const std::size_t INITIAL_SLOTS = 256;
+
+}
+
+// constructor
+NameHistogram::NameHistogram()
+    : table(INITIAL_SLOTS)
+{
+    names.reserve(INITIAL_SLOTS * 16);
+}
+
+/*
+    Count one occurrence of the name. A new name is interned.
+
+    @param name Name to count
+*/
+void NameHistogram::add(std::string_view name) {
+
+    const std::uint32_t hash = fnvHash32(name);
+    const std::size_t mask = table.size() - 1;
+    std::size_t slot = hash & mask;
+    while (table[slot].count != 0) {
+        Entry& entry = table[slot];
+        if (entry.hash == hash && entry.length == name.size()
+            && std::memcmp(names.data() + entry.offset, name.data(), name.size()) == 0) {
+            ++entry.count;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // new name
+    Entry& entry = table[slot];
+    entry.offset = (std::uint32_t) names.size();
+    entry.length = (std::uint32_t) name.size();
+    entry.hash = hash;
+    entry.count = 1;
+    names.append(name.data(), name.size());
+    if (++used * 2 > table.size())
+        grow();
+}
+
+// double the table, reinserting the entries
+void NameHistogram::grow() {
+
+    std::vector<Entry> old(table.size() * 2);
+    old.swap(table);
+    const std::size_t mask = table.size() - 1;
+    for (const Entry& entry : old) {
+        if (entry.count == 0)
+            continue;
+        std::size_t slot = entry.hash & mask;
+        while (table[slot].count != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = entry;
+    }
+}
+
+// number of distinct names
+std::size_t NameHistogram::size() const {
+
+    return used;
+}
+
+// names and counts, by decreasing count and then by name
+std::vector<std::pair<std::string_view, long>> NameHistogram::sorted() const {
+
+    std::vector<std::pair<std::string_view, long>> result;
+    result.reserve(used);
+    for (const Entry& entry : table) {
+        if (entry.count != 0)
+            result.emplace_back(std::string_view(names.data() + entry.offset, entry.length), entry.count);
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    return result;
+}
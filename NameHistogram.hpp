@@ -0,0 +1,51 @@
+/*
+    NameHistogram.hpp
+
+    Declaration of a histogram of names in an open-addressing flat hash map
+*/
+
+#ifndef INCLUDE_NAMEHISTOGRAM_HPP
+#define INCLUDE_NAMEHISTOGRAM_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class NameHistogram {
+public:
+
+    // constructor
+    NameHistogram();
+
+    // count one occurrence of the name
+    void add(std::string_view name);
+
+    // number of distinct names
+    std::size_t size() const;
+
+    // names and counts, by decreasing count and then by name
+    std::vector<std::pair<std::string_view, long>> sorted() const;
+
+private:
+    // double the table, reinserting the entries
+    void grow();
+
+    // a slot of the table
+    struct Entry {
+        // position of the name in the names arena
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+        std::uint32_t hash = 0;
+        // 0 for an empty slot
+        long count = 0;
+    };
+
+    std::vector<Entry> table;
+    // each name is stored once, interned, in one buffer
+    std::string names;
+    std::size_t used = 0;
+};
+
+#endif
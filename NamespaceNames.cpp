@@ -0,0 +1,209 @@
+/*
+    NamespaceNames.cpp
+
+    Implement a table of namespace IDs with scoped prefix bindings
+
+    Namespace URIs are interned once, when declared, with the srcML
+    namespaces at fixed IDs. A declaration pushes a binding of its
+    prefix, tagged with the depth of the element's content, and the
+    binding is popped when a tag at a lesser depth is parsed. The
+    stack only changes at declarations, so after the first unit it
+    reuses its storage and parsing an element does not allocate.
+
+    Resolving a prefix scans the bindings in scope from the innermost.
+    That is a handful of entries in srcML, e.g., the default src and
+    the cpp namespace, whatever the size of the document. The default
+    namespace is kept aside, so unprefixed names, most srcML elements,
+    resolve with a single load.
+ */
+
+#include "NamespaceNames.hpp"
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+const std::string_view XML_PREFIX = "xml";
+
+// URIs of the known namespaces, indexed by ID
+const std::string_view KNOWN_URIS[] = {
+    "",
+    "http://www.w3.org/XML/1998/namespace",
+    "http://www.srcML.org/srcML/src",
+    "http://www.srcML.org/srcML/cpp",
+    "http://www.srcML.org/srcML/srcerr",
+    "http://www.srcML.org/srcML/position",
+    "http://www.srcML.org/srcML/openmp",
+};
+
+static_assert(sizeof(KNOWN_URIS) / sizeof(KNOWN_URIS[0]) == NAMESPACE_COUNT, "URI for each known namespace");
+
+}
+
+/*
+    Bind the prefix to the namespace for an element and its content.
+    An empty URI undeclares the default namespace.
+
+    @param prefix Prefix, or empty for the default namespace
+    @param uri Namespace URI
+    @param depth Depth of the content of the declaring element
+*/
+void NamespaceNames::declare(std::string_view prefix, std::string_view uri, int depth) {
+
+    closeScopes(depth);
+
+    const NamespaceID namespaceID = uri.empty() ? NAMESPACE_NONE : id(uri);
+    bindings.push_back(Binding{ depth, (std::uint32_t) prefixes.size(), (std::uint32_t) prefix.size(), namespaceID });
+    prefixes.append(prefix.data(), prefix.size());
+    if (prefix.empty())
+        defaultNamespace = namespaceID;
+}
+
+/*
+    End all bindings, e.g., for the next document of a reused parser.
+    The interned URIs keep their IDs, and the binding stack keeps its
+    storage, so the next document does not allocate either.
+*/
+void NamespaceNames::reset() {
+
+    bindings.clear();
+    prefixes.clear();
+    defaultNamespace = NAMESPACE_NONE;
+}
+
+/*
+    Bind the namespaces declared in the attributes of a start tag,
+    i.e., xmlns and xmlns:prefix. Other attributes are skipped.
+
+    @param attributes Attributes of the start tag, after the element name
+    @param depth Depth of the content of the element
+*/
+void NamespaceNames::declareAttributes(std::string_view attributes, int depth) {
+
+    std::size_t pos = 0;
+    while (true) {
+        while (pos < attributes.size() && isspace(attributes[pos]))
+            ++pos;
+        const std::size_t equals = attributes.find('=', pos);
+        if (equals == std::string_view::npos)
+            return;
+        std::string_view name = attributes.substr(pos, equals - pos);
+        while (!name.empty() && isspace(name.back()))
+            name.remove_suffix(1);
+
+        pos = equals + 1;
+        while (pos < attributes.size() && isspace(attributes[pos]))
+            ++pos;
+        if (pos == attributes.size() || (attributes[pos] != '"' && attributes[pos] != '\''))
+            return;
+        const std::size_t valueEnd = attributes.find(attributes[pos], pos + 1);
+        if (valueEnd == std::string_view::npos)
+            return;
+        const std::string_view value = attributes.substr(pos + 1, valueEnd - pos - 1);
+        pos = valueEnd + 1;
+
+        if (name.substr(0, 5) != "xmlns")
+            continue;
+        if (name.size() == 5)
+            declare(std::string_view(), value, depth);
+        else if (name[5] == ':')
+            declare(name.substr(6), value, depth);
+    }
+}
+
+/*
+    ID of the namespace URI. The srcML namespaces have fixed IDs, and
+    other URIs get IDs from NAMESPACE_COUNT on, per table.
+
+    @param uri Namespace URI
+    @return ID of the URI
+*/
+NamespaceID NamespaceNames::id(std::string_view uri) {
+
+    for (int known = NAMESPACE_XML; known < NAMESPACE_COUNT; ++known) {
+        if (KNOWN_URIS[known] == uri)
+            return (NamespaceID) known;
+    }
+    for (std::size_t i = 0; i < uris.size(); ++i) {
+        if (uris[i] == uri)
+            return (NamespaceID) (NAMESPACE_COUNT + i);
+    }
+    uris.emplace_back(uri);
+
+    return (NamespaceID) (NAMESPACE_COUNT + uris.size() - 1);
+}
+
+// URI of the namespace ID
+std::string_view NamespaceNames::uri(NamespaceID id) const {
+
+    if (id < NAMESPACE_COUNT)
+        return KNOWN_URIS[id];
+
+    return uris[id - NAMESPACE_COUNT];
+}
+
+// number of IDs, known and interned
+int NamespaceNames::size() const {
+
+    return NAMESPACE_COUNT + (int) uris.size();
+}
+
+/*
+    Bindings of the elements at depth or less, e.g., the open elements
+    at the start of a tag at that depth.
+
+    @param depth Depth of the innermost element
+    @return Prefix and URI of each binding, outermost first
+*/
+std::vector<std::pair<std::string, std::string>> NamespaceNames::scope(int depth) const {
+
+    std::vector<std::pair<std::string, std::string>> result;
+    for (const Binding& binding : bindings) {
+        if (binding.depth <= depth)
+            result.emplace_back(prefixes.substr(binding.prefixOffset, binding.prefixLength), std::string(uri(binding.id)));
+    }
+
+    return result;
+}
+
+/*
+    ID of the namespace bound to a non-empty prefix. The xml prefix is
+    always bound.
+
+    @param prefix Prefix of a qualified name
+    @return ID of the namespace, or NAMESPACE_NONE if the prefix is not bound
+*/
+NamespaceID NamespaceNames::resolvePrefix(std::string_view prefix) const {
+
+    for (auto binding = bindings.crbegin(); binding != bindings.crend(); ++binding) {
+        if (binding->prefixLength == prefix.size()
+            && std::memcmp(prefixes.data() + binding->prefixOffset, prefix.data(), prefix.size()) == 0)
+            return binding->id;
+    }
+    if (prefix == XML_PREFIX)
+        return NAMESPACE_XML;
+
+    return NAMESPACE_NONE;
+}
+
+// end the bindings of elements deeper than depth
+void NamespaceNames::popScopes(int depth) {
+
+    bool defaultChanged = false;
+    while (!bindings.empty() && bindings.back().depth > depth) {
+        defaultChanged = defaultChanged || bindings.back().prefixLength == 0;
+        prefixes.resize(bindings.back().prefixOffset);
+        bindings.pop_back();
+    }
+
+    // the default namespace of an outer element is in scope again
+    if (defaultChanged) {
+        defaultNamespace = NAMESPACE_NONE;
+        for (auto binding = bindings.crbegin(); binding != bindings.crend(); ++binding) {
+            if (binding->prefixLength == 0) {
+                defaultNamespace = binding->id;
+                break;
+            }
+        }
+    }
+}
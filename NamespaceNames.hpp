@@ -0,0 +1,92 @@
+/*
+    NamespaceNames.hpp
+
+    Declaration of a table of namespace IDs with scoped prefix bindings
+*/
+
+#ifndef INCLUDE_NAMESPACENAMES_HPP
+#define INCLUDE_NAMESPACENAMES_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// IDs of the srcML namespaces, and of the XML namespace
+enum NamespaceID : int {
+    // no namespace, e.g., an unprefixed attribute, or an undeclared prefix
+    NAMESPACE_NONE,
+    NAMESPACE_XML,
+    NAMESPACE_SRC,
+    NAMESPACE_CPP,
+    NAMESPACE_ERR,
+    NAMESPACE_POS,
+    NAMESPACE_OMP,
+    NAMESPACE_COUNT
+};
+
+class NamespaceNames {
+public:
+
+    // ID of the namespace bound to the prefix, with the empty prefix for the default namespace
+    NamespaceID resolve(std::string_view prefix) const {
+
+        if (prefix.empty())
+            return defaultNamespace;
+
+        return resolvePrefix(prefix);
+    }
+
+    // bind the prefix to the namespace for an element with content at depth
+    void declare(std::string_view prefix, std::string_view uri, int depth);
+
+    // bind the namespaces declared in the attributes of a start tag
+    void declareAttributes(std::string_view attributes, int depth);
+
+    // end the bindings of elements deeper than depth
+    void closeScopes(int depth) {
+
+        if (!bindings.empty() && bindings.back().depth > depth)
+            popScopes(depth);
+    }
+
+    // ID of the namespace URI, interning URIs other than the srcML ones
+    NamespaceID id(std::string_view uri);
+
+    // URI of the namespace ID
+    std::string_view uri(NamespaceID id) const;
+
+    // number of IDs, known and interned
+    int size() const;
+
+    // end all bindings for another document, keeping the interned URIs and the storage
+    void reset();
+
+    // bindings of elements at depth or less, as prefix and URI, outermost first
+    std::vector<std::pair<std::string, std::string>> scope(int depth) const;
+
+private:
+    // ID of the namespace bound to a non-empty prefix
+    NamespaceID resolvePrefix(std::string_view prefix) const;
+
+    // end the bindings of elements deeper than depth
+    void popScopes(int depth);
+
+    // a prefix binding, with the prefix in the prefixes buffer
+    struct Binding {
+        int depth;
+        std::uint32_t prefixOffset;
+        std::uint32_t prefixLength;
+        NamespaceID id;
+    };
+
+    // bindings in scope, innermost last
+    std::vector<Binding> bindings;
+    // prefixes of the bindings, in the same order, so popping truncates
+    std::string prefixes;
+    NamespaceID defaultNamespace = NAMESPACE_NONE;
+    std::vector<std::string> uris;
+};
+
+#endif
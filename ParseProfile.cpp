@@ -0,0 +1,259 @@
+/*
+    ParseProfile.cpp
+
+    Implement a profile of the parse by stage
+
+    Every part of the parse, e.g., a start tag, is counted with its
+    bytes, but only one part in SAMPLE_INTERVAL is timed, since
+    reading the clock for each part costs about as much as parsing
+    it. The time of a stage is estimated from its timed parts. The
+    time of handler calls in a timed part is taken out of its stage
+    and counted as the handlers stage. Refills are few, and each one
+    is timed, with the wait also in a histogram.
+
+    A clock read takes about as long as a short part, e.g., an end
+    tag, so the time of the reads in each interval, measured once at
+    startup, is taken out of it. Even so, a timed part runs slower
+    than an untimed one, so the times of the stages are only used as
+    shares of the elapsed time of the parse.
+
+    Ticks are from the time-stamp counter on x86, and nanoseconds of
+    std::chrono::steady_clock otherwise. Ticks are converted to
+    seconds with the rate over the run.
+
+    The parsers of a process add their profiles to a total, which is
+    written to stderr at exit as a table, or, if the environment
+    variable SRCFACTS_PROFILE_JSON is set, as JSON to that file.
+ */
+
+#include "ParseProfile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PROFILE_RDTSC 1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILE_RDTSC 1
+#endif
+
+namespace {
+
+const char* const STAGE_NAMES[STAGE_COUNT] = { "refill", "declaration", "endTag", "startTag", "namespace", "attribute",
+    "cdata", "comment", "charactersBeforeOrAfter", "entityReference", "characters", "handlers" };
+
+// ticks of a clock read, the least of many back to back
+std::uint64_t measureClockTicks() {
+
+    std::uint64_t least = ~0ull;
+    for (int i = 0; i < 1000; ++i) {
+        const std::uint64_t first = ParseProfile::now();
+        const std::uint64_t second = ParseProfile::now();
+        least = std::min(least, second - first);
+    }
+
+    return least;
+}
+
+// start of the run in ticks and in time, for the tick rate
+const std::uint64_t startTicks = ParseProfile::now();
+const auto startTime = std::chrono::steady_clock::now();
+
+// ticks per second over the run
+double tickRate() {
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    if (elapsed.count() <= 0)
+        return 1e9;
+
+    return (double) (ParseProfile::now() - startTicks) / elapsed.count();
+}
+
+// total of all the parsers, written at exit
+class TotalProfile {
+public:
+
+    // destructor, writing the total profile
+    ~TotalProfile() {
+
+        const char* path = std::getenv("SRCFACTS_PROFILE_JSON");
+        if (path) {
+            std::ofstream out(path);
+            profile.writeJSON(out);
+            return;
+        }
+        profile.writeTable(std::cerr);
+    }
+
+    ParseProfile profile;
+    std::mutex mutex;
+};
+
+TotalProfile total;
+
+}
+
+// constructor
+ParseProfile::ParseProfile() {
+
+    static const std::uint64_t measuredClockTicks = measureClockTicks();
+    clockTicks = measuredClockTicks;
+}
+
+/*
+    Time in ticks.
+
+    @return Cycles of the time-stamp counter, or nanoseconds
+*/
+std::uint64_t ParseProfile::now() {
+
+#if defined(PROFILE_RDTSC)
+    return __rdtsc();
+#else
+    return (std::uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*
+    Add a refill. The wait is also in the histogram, in the bucket of
+    its power of two of ticks.
+
+    @param refillTicks Time of the refill
+    @param size Bytes added to the buffer
+*/
+void ParseProfile::addRefill(std::uint64_t refillTicks, long size) {
+
+    ++events[STAGE_REFILL];
+    ++sampledEvents[STAGE_REFILL];
+    bytes[STAGE_REFILL] += size;
+    ticks[STAGE_REFILL] += withoutReads(refillTicks, 1);
+    if (timing)
+        nestedTicks += refillTicks;
+
+    int bucket = 0;
+    while (bucket + 1 < REFILL_BUCKETS && (refillTicks >> (bucket + 1)) != 0)
+        ++bucket;
+    ++refillHistogram[bucket];
+}
+
+// add the counts of another profile, e.g., of another thread
+void ParseProfile::merge(const ParseProfile& other) {
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        events[stage] += other.events[stage];
+        bytes[stage] += other.bytes[stage];
+        sampledEvents[stage] += other.sampledEvents[stage];
+        ticks[stage] += other.ticks[stage];
+    }
+    for (int bucket = 0; bucket < REFILL_BUCKETS; ++bucket)
+        refillHistogram[bucket] += other.refillHistogram[bucket];
+    parts += other.parts;
+    parseTicks += other.elapsedTicks();
+}
+
+// add a profile to the total of the process, reported at exit
+void ParseProfile::mergeTotal(const ParseProfile& profile) {
+
+    std::lock_guard<std::mutex> lock(total.mutex);
+    total.profile.merge(profile);
+}
+
+/*
+    Estimated ticks of a stage. The timed parts are scaled to all
+    parts, and then the stages to the elapsed time of the parse.
+
+    @param stage Stage of the parse
+    @return Estimated ticks, or 0 if no part was timed
+*/
+double ParseProfile::estimatedTicks(int stage) const {
+
+    if (sampledEvents[stage] == 0)
+        return 0;
+
+    double sampledTotal = 0;
+    for (int other = 0; other < STAGE_COUNT; ++other) {
+        if (sampledEvents[other] != 0)
+            sampledTotal += (double) ticks[other] * (double) events[other] / (double) sampledEvents[other];
+    }
+    const double sampled = (double) ticks[stage] * (double) events[stage] / (double) sampledEvents[stage];
+    if (sampledTotal <= 0 || elapsedTicks() == 0)
+        return sampled;
+
+    return sampled / sampledTotal * (double) elapsedTicks();
+}
+
+/*
+    Write the profile as a table, with a row per stage, then the
+    histogram of refill waits.
+
+    @param out Stream to write to
+*/
+void ParseProfile::writeTable(std::ostream& out) const {
+
+    const double rate = tickRate();
+    double totalTicks = 0;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage)
+        totalTicks += estimatedTicks(stage);
+
+    out << "| Stage | Events | Bytes | Seconds | % | ns/event |\n";
+    out << "|:-----|-----:|-----:|-----:|-----:|-----:|\n";
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (events[stage] == 0)
+            continue;
+        const double seconds = estimatedTicks(stage) / rate;
+        out << "| " << STAGE_NAMES[stage] << " | " << events[stage] << " | " << bytes[stage]
+            << " | " << std::fixed << std::setprecision(6) << seconds
+            << " | " << std::setprecision(1) << (totalTicks > 0 ? 100 * estimatedTicks(stage) / totalTicks : 0)
+            << " | " << seconds * 1e9 / (double) events[stage] << " |\n";
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+
+    if (events[STAGE_REFILL] == 0)
+        return;
+    out << '\n';
+    out << "| Refill wait up to (us) | Refills |\n";
+    out << "|-----:|-----:|\n";
+    for (int bucket = 0; bucket < REFILL_BUCKETS; ++bucket) {
+        if (refillHistogram[bucket] == 0)
+            continue;
+        out << "| " << (double) (2ull << bucket) / rate * 1e6 << " | " << refillHistogram[bucket] << " |\n";
+    }
+}
+
+/*
+    Write the profile as JSON, with the stages and the histogram of
+    refill waits, as the upper bound of each bucket in seconds.
+
+    @param out Stream to write to
+*/
+void ParseProfile::writeJSON(std::ostream& out) const {
+
+    const double rate = tickRate();
+    out << "{\n";
+    out << "  \"sampleInterval\": " << SAMPLE_INTERVAL << ",\n";
+    out << "  \"ticksPerSecond\": " << rate << ",\n";
+    out << "  \"seconds\": " << (double) elapsedTicks() / rate << ",\n";
+    out << "  \"stages\": [\n";
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        out << "    { \"stage\": \"" << STAGE_NAMES[stage] << "\", \"events\": " << events[stage]
+            << ", \"bytes\": " << bytes[stage] << ", \"timedEvents\": " << sampledEvents[stage]
+            << ", \"seconds\": " << estimatedTicks(stage) / rate << " }" << (stage + 1 < STAGE_COUNT ? "," : "") << '\n';
+    }
+    out << "  ],\n";
+    out << "  \"refillWaits\": [";
+    bool first = true;
+    for (int bucket = 0; bucket < REFILL_BUCKETS; ++bucket) {
+        if (refillHistogram[bucket] == 0)
+            continue;
+        out << (first ? " " : ", ") << "{ \"upTo\": " << (double) (2ull << bucket) / rate << ", \"refills\": " << refillHistogram[bucket] << " }";
+        first = false;
+    }
+    out << " ]\n";
+    out << "}\n";
+}
@@ -0,0 +1,165 @@
+/*
+    ParseProfile.hpp
+
+    Declaration of a profile of the parse by stage, for builds with SRCFACTS_PROFILE
+*/
+
+#ifndef INCLUDE_PARSEPROFILE_HPP
+#define INCLUDE_PARSEPROFILE_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// stages of the parse, each a row of the profile
+enum ProfileStage {
+    STAGE_REFILL,
+    STAGE_DECLARATION,
+    STAGE_END_TAG,
+    STAGE_START_TAG,
+    STAGE_NAMESPACE,
+    STAGE_ATTRIBUTE,
+    STAGE_CDATA,
+    STAGE_COMMENT,
+    STAGE_CHARACTERS_BEFORE_OR_AFTER,
+    STAGE_ENTITY_REFERENCE,
+    STAGE_CHARACTERS,
+    STAGE_HANDLERS,
+    STAGE_COUNT
+};
+
+class ParseProfile {
+public:
+
+    // one part in SAMPLE_INTERVAL is timed
+    static constexpr long SAMPLE_INTERVAL = 64;
+
+    // buckets of the refill latency histogram, powers of two of ticks
+    static constexpr int REFILL_BUCKETS = 40;
+
+    // constructor
+    ParseProfile();
+
+    // time in ticks, cycles where there is a time-stamp counter
+    static std::uint64_t now();
+
+    // start a part of the parse, returning whether it is timed
+    bool startPart() {
+
+        timing = ++parts % SAMPLE_INTERVAL == 0;
+        if (parts == 1)
+            firstTicks = now();
+        nestedTicks = 0;
+        partHandlers = 0;
+        return timing;
+    }
+
+    // end a part of the parse, with the start time if it is timed
+    void endPart(ProfileStage stage, long size, std::uint64_t start) {
+
+        ++events[stage];
+        bytes[stage] += size;
+        if (timing) {
+            // each handler call reads the clock twice inside the part
+            lastTicks = now();
+            ++sampledEvents[stage];
+            ticks[stage] += withoutReads(lastTicks - start - nestedTicks, 1 + partHandlers);
+            timing = false;
+        }
+    }
+
+    // start a handler call, returning the start time if the part is timed, or 0
+    std::uint64_t startHandler() {
+
+        ++events[STAGE_HANDLERS];
+        return timing ? now() : 0;
+    }
+
+    // end a handler call, with its start time
+    void endHandler(std::uint64_t start) {
+
+        if (start) {
+            const std::uint64_t handlerTicks = now() - start;
+            ++sampledEvents[STAGE_HANDLERS];
+            ticks[STAGE_HANDLERS] += withoutReads(handlerTicks, 1);
+            nestedTicks += handlerTicks;
+            ++partHandlers;
+        }
+    }
+
+    // add a refill, which is always timed, with its wait in the histogram
+    void addRefill(std::uint64_t refillTicks, long size);
+
+    // add the counts of another profile, e.g., of another thread
+    void merge(const ParseProfile& other);
+
+    // profile of all the parsers of the process, reported at exit
+    static void mergeTotal(const ParseProfile& profile);
+
+    // write the profile as a table
+    void writeTable(std::ostream& out) const;
+
+    // write the profile as JSON
+    void writeJSON(std::ostream& out) const;
+
+private:
+    // estimated ticks of a stage, from the timed parts
+    double estimatedTicks(int stage) const;
+
+    // ticks of the parse, from the first part to the last timed part
+    std::uint64_t elapsedTicks() const {
+
+        return parseTicks + (lastTicks > firstTicks ? lastTicks - firstTicks : 0);
+    }
+
+    // ticks of an interval less the time of the clock reads in it
+    std::uint64_t withoutReads(std::uint64_t intervalTicks, int reads) const {
+
+        const std::uint64_t readTicks = (std::uint64_t) reads * clockTicks;
+        return intervalTicks > readTicks ? intervalTicks - readTicks : 0;
+    }
+
+    std::array<long, STAGE_COUNT> events{};
+    std::array<long, STAGE_COUNT> bytes{};
+    std::array<long, STAGE_COUNT> sampledEvents{};
+    std::array<std::uint64_t, STAGE_COUNT> ticks{};
+    std::array<long, REFILL_BUCKETS> refillHistogram{};
+    long parts = 0;
+    bool timing = false;
+    // ticks of the parse, with the parses merged into this one
+    std::uint64_t firstTicks = 0;
+    std::uint64_t lastTicks = 0;
+    std::uint64_t parseTicks = 0;
+    // ticks of handlers and refills in the current part, not of its stage
+    std::uint64_t nestedTicks = 0;
+    int partHandlers = 0;
+    // ticks of a clock read
+    std::uint64_t clockTicks = 0;
+};
+
+/*
+    Set the stage of the part in XMLParserBase::parseNext(). Without
+    SRCFACTS_PROFILE, it is nothing.
+*/
+#if defined(SRCFACTS_PROFILE)
+#define PROFILE_STAGE(name) stage = name
+#else
+#define PROFILE_STAGE(name)
+#endif
+
+/*
+    Time a handler call in a timed part. Without SRCFACTS_PROFILE, it
+    is just the call.
+*/
+#if defined(SRCFACTS_PROFILE)
+#define PROFILE_HANDLER(call) \
+    do { \
+        const std::uint64_t handlerStart = profile.startHandler(); \
+        call; \
+        profile.endHandler(handlerStart); \
+    } while (false)
+#else
+#define PROFILE_HANDLER(call) call
+#endif
+
+#endif
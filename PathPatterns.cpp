@@ -0,0 +1,199 @@
+/*
+    PathPatterns.cpp
+
+    Implement a set of element path patterns, compiled into one
+    automaton over the start tags
+
+    A pattern is element local names, or '*' for any element, joined
+    by '/' for a child and '//' for any descendant, e.g., "class//function"
+    or "function/parameter_list/parameter/decl". A pattern matches an
+    element at any depth, unless it starts with a single '/', when its
+    first step is the root element.
+
+    The patterns are compiled together into a deterministic automaton
+    over element IDs, from the sets of the steps that may match next.
+    A start tag is one table lookup from the state of its parent, so
+    the work for each tag is the same however many patterns there are.
+    The automaton is read only, and shared by the matchers of parsers
+    on other threads.
+ */
+
+#include "PathPatterns.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+// most states of an automaton, far more than reasonable patterns need
+const int MAX_STATES = 1 << 16;
+
+// text without leading and trailing whitespace
+std::string_view trim(std::string_view text) {
+
+    const auto first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos)
+        return std::string_view();
+    const auto last = text.find_last_not_of(" \t\r\n");
+
+    return text.substr(first, last - first + 1);
+}
+
+}
+
+/*
+    Add a pattern. Names are local names, so a prefix is dropped, and
+    must be srcML elements. The patterns are matched after compile().
+
+    @param pattern Pattern text, e.g., "class//function"
+    @return false if the pattern is empty, has an empty step, or an unknown element
+*/
+bool PathPatterns::add(std::string_view pattern) {
+
+    std::vector<Step> patternSteps;
+    std::string_view rest = pattern;
+    bool descendant = true;
+    if (rest.substr(0, 2) == "//") {
+        rest.remove_prefix(2);
+    } else if (rest.substr(0, 1) == "/") {
+        descendant = false;
+        rest.remove_prefix(1);
+    }
+    while (true) {
+        const auto slash = rest.find('/');
+        std::string_view name = rest.substr(0, slash);
+        const auto colon = name.find(':');
+        if (colon != std::string_view::npos)
+            name.remove_prefix(colon + 1);
+        if (name.empty())
+            return false;
+        const int element = name == "*" ? ANY : knownElementID(name);
+        if (element == -1 && name != "*")
+            return false;
+        patternSteps.push_back({ element, descendant, (int) patterns.size(), false });
+        if (slash == std::string_view::npos)
+            break;
+        rest.remove_prefix(slash + 1);
+        descendant = rest.substr(0, 1) == "/";
+        if (descendant)
+            rest.remove_prefix(1);
+    }
+    patternSteps.back().last = true;
+
+    firstSteps.push_back((int) steps.size());
+    steps.insert(steps.end(), patternSteps.begin(), patternSteps.end());
+    patterns.emplace_back(pattern);
+
+    return true;
+}
+
+/*
+    Read patterns from a file, one per line. Blank lines, and lines
+    starting with '#', are skipped.
+
+    @param path Path of the pattern file
+    @return false if the file cannot be read, or a pattern is not valid
+*/
+bool PathPatterns::load(const std::string& path) {
+
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::string_view pattern = trim(line);
+        if (pattern.empty() || pattern[0] == '#')
+            continue;
+        if (!add(pattern))
+            return false;
+    }
+
+    return compile();
+}
+
+/*
+    Compile the patterns into the automaton, with every state and its
+    transitions for all symbols. From a state, an element advances each
+    step it matches, or if the last step of a pattern, matches it, and
+    each descendant step stays for deeper elements.
+
+    @return false if the automaton has too many states
+*/
+bool PathPatterns::compile() {
+
+    states.clear();
+    transitions.clear();
+    stateIndex.clear();
+    state(firstSteps, std::vector<int>());
+    for (std::size_t current = 0; current < states.size(); ++current) {
+        const std::vector<int> currentSteps = states[current].steps;
+        for (int symbol = 0; symbol < SYMBOLS; ++symbol) {
+            std::vector<int> nextSteps;
+            std::vector<int> matches;
+            for (const int index : currentSteps) {
+                const Step& step = steps[index];
+                if (step.descendant)
+                    nextSteps.push_back(index);
+                if (step.element == ANY || step.element == symbol) {
+                    if (step.last)
+                        matches.push_back(step.pattern);
+                    else
+                        nextSteps.push_back(index + 1);
+                }
+            }
+            std::sort(nextSteps.begin(), nextSteps.end());
+            nextSteps.erase(std::unique(nextSteps.begin(), nextSteps.end()), nextSteps.end());
+            std::sort(matches.begin(), matches.end());
+            matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+            transitions.push_back(state(nextSteps, matches));
+        }
+        if ((int) states.size() > MAX_STATES)
+            return false;
+    }
+
+    return true;
+}
+
+// index of the state for steps and matches, added if new
+int PathPatterns::state(const std::vector<int>& nextSteps, const std::vector<int>& matches) {
+
+    // key of the steps, then -1, then the matches
+    std::vector<int> key(nextSteps);
+    key.push_back(-1);
+    key.insert(key.end(), matches.begin(), matches.end());
+    const auto found = stateIndex.find(key);
+    if (found != stateIndex.end())
+        return found->second;
+
+    states.push_back({ nextSteps, matches });
+    stateIndex.emplace(std::move(key), (int) states.size() - 1);
+
+    return (int) states.size() - 1;
+}
+
+// constructor for the compiled patterns, which must outlive the matcher
+PathPatterns::Matcher::Matcher(const PathPatterns& patterns)
+    : patterns(patterns), stack(1, 0)
+{}
+
+/*
+    Match the start tag of an element. The state of its parent is the
+    state after depth open elements, so an empty element, which has no
+    end tag, is replaced by its next sibling. A parse that starts inside
+    the root, e.g., of a file unit of an archive, has the root, a srcML
+    unit, open.
+
+    @param depth Number of open ancestors of the element
+    @param id Element ID of the local name
+    @return Indexes of the patterns matched by the element
+*/
+const std::vector<int>& PathPatterns::Matcher::open(int depth, ElementID id) {
+
+    const int symbol = id < ELEMENT_COUNT ? (int) id : ELEMENT_COUNT;
+    while ((int) stack.size() <= depth)
+        stack.push_back(patterns.transitions[stack.back() * SYMBOLS + ELEMENT_UNIT]);
+    stack.resize(depth + 1);
+    const int next = patterns.transitions[stack.back() * SYMBOLS + symbol];
+    stack.push_back(next);
+
+    return patterns.states[next].matches;
+}
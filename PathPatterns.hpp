@@ -0,0 +1,88 @@
+/*
+    PathPatterns.hpp
+
+    Declaration of a set of element path patterns, compiled into one
+    automaton over the start tags
+*/
+
+#ifndef INCLUDE_PATHPATTERNS_HPP
+#define INCLUDE_PATHPATTERNS_HPP
+
+#include "srcMLElements.hpp"
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class PathPatterns {
+public:
+
+    // add a pattern, e.g., "class//function", returning false if it is not valid
+    bool add(std::string_view pattern);
+
+    // read patterns from a file, one per line, and compile them, returning false if the file or a pattern is not valid
+    bool load(const std::string& path);
+
+    // compile the patterns into the automaton, returning false if it is too large
+    bool compile();
+
+    // number of patterns
+    int size() const { return (int) patterns.size(); }
+
+    // no patterns
+    bool empty() const { return patterns.empty(); }
+
+    // text of a pattern
+    const std::string& pattern(int index) const { return patterns[index]; }
+
+    // matches the start tags of a parse against the compiled patterns
+    class Matcher {
+    public:
+
+        // constructor for the compiled patterns, which must outlive the matcher
+        explicit Matcher(const PathPatterns& patterns);
+
+        // patterns matched by the start tag of an element with depth open ancestors
+        const std::vector<int>& open(int depth, ElementID id);
+
+    private:
+        const PathPatterns& patterns;
+        // state after each open element, with the state before the root first
+        std::vector<int> stack;
+    };
+
+private:
+    // element of a step for '*'
+    static constexpr int ANY = -1;
+
+    // symbols of the automaton, the srcML elements and one for all other names
+    static constexpr int SYMBOLS = ELEMENT_COUNT + 1;
+
+    // a step of a pattern, in order, with the last step of each pattern marked
+    struct Step {
+        int element;
+        // step is any descendant, after '//', instead of a child, after '/'
+        bool descendant;
+        int pattern;
+        bool last;
+    };
+
+    // a state of the automaton, i.e., the steps to match next, and the patterns just matched
+    struct State {
+        std::vector<int> steps;
+        std::vector<int> matches;
+    };
+
+    // index of the state for steps and matches, added if new
+    int state(const std::vector<int>& nextSteps, const std::vector<int>& matches);
+
+    std::vector<std::string> patterns;
+    std::vector<Step> steps;
+    std::vector<int> firstSteps;
+    std::vector<State> states;
+    // next state by state and symbol
+    std::vector<int> transitions;
+    std::map<std::vector<int>, int> stateIndex;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    SPSCQueue.hpp
+
+    Declaration and implementation of a lock-free single-producer,
+    single-consumer queue
+
+    One thread may push and one other thread may pop. The head and
+    tail are on separate cache lines so the two threads do not
+    contend on them.
+ */
+
+#ifndef INCLUDED_SPSCQUEUE_HPP
+#define INCLUDED_SPSCQUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+template <class T, std::size_t Capacity>
+class SPSCQueue {
+public:
+
+    // add a value, returning false if the queue is full (producer only)
+    bool push(const T& value);
+
+    // remove a value, returning false if the queue is empty (consumer only)
+    bool pop(T& value);
+
+private:
+    // one slot is left open to tell full from empty
+    static constexpr std::size_t SIZE = Capacity + 1;
+
+    T slots[SIZE];
+    alignas(64) std::atomic<std::size_t> head{0};
+    alignas(64) std::atomic<std::size_t> tail{0};
+};
+
+// add a value, returning false if the queue is full (producer only)
+template <class T, std::size_t Capacity>
+bool SPSCQueue<T, Capacity>::push(const T& value) {
+
+    const std::size_t t = tail.load(std::memory_order_relaxed);
+    const std::size_t next = (t + 1) % SIZE;
+    if (next == head.load(std::memory_order_acquire))
+        return false;
+    slots[t] = value;
+    tail.store(next, std::memory_order_release);
+
+    return true;
+}
+
+// remove a value, returning false if the queue is empty (consumer only)
+template <class T, std::size_t Capacity>
+bool SPSCQueue<T, Capacity>::pop(T& value) {
+
+    const std::size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire))
+        return false;
+    value = slots[h];
+    head.store((h + 1) % SIZE, std::memory_order_release);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+    SpanWriter.cpp
+
+    Implement an output writer that gathers spans of memory
+
+    Unchanged input is not copied. Each forwarded span is a pointer and
+    a length in a gather list, with adjacent spans merged, and the list
+    is written with writev. When the output is a pipe and the input is
+    stable, e.g., mapped, the list is given to vmsplice instead, so the
+    pipe refers to the input pages rather than copying them. Only
+    inserted text is copied.
+ */
+
+#include "SpanWriter.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <errno.h>
+#include <limits.h>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#include <BaseTsd.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#endif
+
+#if !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
+// constructor
+SpanWriter::SpanWriter(int fd)
+    : fd(fd)
+{
+#if defined(__linux__)
+    struct stat st;
+    pipeOutput = fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+#endif
+}
+
+// destructor, writing any pending spans
+SpanWriter::~SpanWriter() {
+
+    flush();
+}
+
+// forwarded spans are never changed or unmapped while output may refer to them
+void SpanWriter::setStableInput(bool stable) {
+
+    stableInput = stable;
+}
+
+/*
+    Forward a span of input. The span is not copied, so it must stay
+    unchanged until the next flush.
+
+    @param span Input to output as is
+*/
+void SpanWriter::forward(std::string_view span) {
+
+    if (span.empty())
+        return;
+
+    // extend the last span when this one follows it in memory
+    if (!spans.empty() && spans.back().data && spans.back().data + spans.back().length == span.data()) {
+        spans.back().length += span.size();
+        return;
+    }
+
+    spans.push_back(Span{ span.data(), 0, span.size() });
+}
+
+/*
+    Output a copy of the text.
+
+    @param text Text to output
+*/
+void SpanWriter::insert(std::string_view text) {
+
+    if (text.empty())
+        return;
+
+    // extend the last span when it is the end of the inserted text
+    if (!spans.empty() && !spans.back().data && spans.back().offset + spans.back().length == inserted.size())
+        spans.back().length += text.size();
+    else
+        spans.push_back(Span{ nullptr, inserted.size(), text.size() });
+    inserted.append(text.data(), text.size());
+}
+
+// write all pending spans
+void SpanWriter::flush() {
+
+    if (spans.empty())
+        return;
+
+    writeSpans();
+    spans.clear();
+    inserted.clear();
+}
+
+// write the spans with writev, or with vmsplice to a pipe
+void SpanWriter::writeSpans() {
+
+#if !defined(_MSC_VER)
+    std::vector<struct iovec> iov;
+    iov.reserve(spans.size());
+    for (const auto& span : spans) {
+        const char* data = span.data ? span.data : inserted.data() + span.offset;
+        iov.push_back({ (void*) data, span.length });
+    }
+
+    // the pipe keeps references to the pages, so only stable input is spliced
+    bool splice = pipeOutput && stableInput && inserted.empty();
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        const int count = (int) std::min<std::size_t>(iov.size() - first, IOV_MAX);
+#if defined(__linux__)
+        ssize_t numbytes = splice ? vmsplice(fd, &iov[first], (unsigned long) count, 0) : writev(fd, &iov[first], count);
+        if (numbytes == -1 && splice && errno != EINTR) {
+            // e.g., not supported, so fall back to copying
+            splice = false;
+            pipeOutput = false;
+            continue;
+        }
+#else
+        ssize_t numbytes = writev(fd, &iov[first], count);
+#endif
+        if (numbytes == -1 && errno == EINTR)
+            continue;
+        if (numbytes <= 0) {
+            std::cerr << "Unable to write output\n";
+            exit(1);
+        }
+
+        // skip what was written, which may end partway into an iovec
+        std::size_t written = (std::size_t) numbytes;
+        while (written > 0 && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            ++first;
+        }
+        if (written > 0) {
+            iov[first].iov_base = (char*) iov[first].iov_base + written;
+            iov[first].iov_len -= written;
+        }
+    }
+#else
+    for (const auto& span : spans) {
+        const char* data = span.data ? span.data : inserted.data() + span.offset;
+        std::size_t length = span.length;
+        while (length > 0) {
+            const int numbytes = _write(fd, data, (unsigned int) std::min<std::size_t>(length, INT_MAX));
+            if (numbytes <= 0) {
+                std::cerr << "Unable to write output\n";
+                exit(1);
+            }
+            data += numbytes;
+            length -= (std::size_t) numbytes;
+        }
+    }
+#endif
+}
@@ -0,0 +1,58 @@
+/*
+    SpanWriter.hpp
+
+    Declaration of an output writer that gathers spans of memory
+*/
+
+#ifndef INCLUDE_SPANWRITER_HPP
+#define INCLUDE_SPANWRITER_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SpanWriter {
+public:
+
+    // constructor
+    explicit SpanWriter(int fd = 1);
+
+    // destructor, writing any pending spans
+    ~SpanWriter();
+
+    SpanWriter(const SpanWriter&) = delete;
+    SpanWriter& operator=(const SpanWriter&) = delete;
+
+    // forwarded spans are never changed or unmapped while output may refer to them
+    void setStableInput(bool stable);
+
+    // forward a span of input, which must stay unchanged until the next flush
+    void forward(std::string_view span);
+
+    // output a copy of the text, e.g., a rewritten token
+    void insert(std::string_view text);
+
+    // write all pending spans
+    void flush();
+
+private:
+    // write the spans with writev, or with vmsplice to a pipe
+    void writeSpans();
+
+    // a pending span, either forwarded memory or a range of the inserted text
+    struct Span {
+        const char* data;
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    int fd;
+    bool pipeOutput = false;
+    bool stableInput = false;
+    std::vector<Span> spans;
+    // copies of inserted text, referred to by offset since the string may grow
+    std::string inserted;
+};
+
+#endif
@@ -0,0 +1,285 @@
+/*
+    UnitIndex.cpp
+
+    Implement a sidecar index of the units of a srcML archive
+
+    The index has the byte range, filename, language, and a hash of
+    each file unit, so the units of one file, or of one directory, are
+    found without scanning the archive. Unit start tags are found as
+    when splitting the archive for parallel parsing (see splitUnits.hpp).
+
+    The index file is binary, in native byte order:
+
+        magic "srcMLidx", version (uint32), reserved (uint32)
+        archive size, root start tag end, unit count, strings size (uint64 each)
+        one Entry per unit, 40 bytes
+        strings, the attribute values of all units
+
+    Since the entries are fixed size and the strings are in one block,
+    the index is read with a few large reads, whatever the number of units.
+ */
+
+#include "UnitIndex.hpp"
+#include "splitUnits.hpp"
+#include "scanDelimiters.hpp"
+#include "fnvHash.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#if !defined(_MSC_VER)
+#include <fnmatch.h>
+#endif
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 's', 'r', 'c', 'M', 'L', 'i', 'd', 'x' };
+const std::uint32_t INDEX_VERSION = 1;
+
+/*
+    Value of an attribute of a start tag. The value is as in the
+    input, with no entities replaced.
+
+    @param tag Start tag, from '<' to '>'
+    @param name Qualified name of the attribute
+    @return The value, or an empty view if the tag has no such attribute
+*/
+std::string_view attributeValue(std::string_view tag, std::string_view name) {
+
+    std::size_t pos = 0;
+    while ((pos = tag.find(name, pos + 1)) != std::string_view::npos) {
+        const std::size_t equals = pos + name.size();
+        if (!isspace(tag[pos - 1]) || equals + 1 >= tag.size() || tag[equals] != '=')
+            continue;
+        const char delim = tag[equals + 1];
+        if (delim != '"' && delim != '\'')
+            continue;
+        const std::size_t valueEnd = tag.find(delim, equals + 2);
+        if (valueEnd == std::string_view::npos)
+            return std::string_view();
+        return tag.substr(equals + 2, valueEnd - (equals + 2));
+    }
+
+    return std::string_view();
+}
+
+// write a value in native byte order
+template <class T>
+void writeValue(std::ofstream& out, T value) {
+
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// read a value in native byte order
+template <class T>
+bool readValue(std::ifstream& in, T& value) {
+
+    return (bool) in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+}
+
+/*
+    Build the index of an archive. The unit start tags are found,
+    and the units hashed, in parallel.
+
+    @param begin Start of the archive
+    @param end End of the archive
+    @param pool Workers to search and hash with
+    @return false if the input is not an archive, i.e., has no nested units
+*/
+bool UnitIndex::build(const char* begin, const char* end, WorkStealingPool& pool) {
+
+    entries.clear();
+    strings.clear();
+    size = (std::uint64_t) std::distance(begin, end);
+
+    const char* rootEndPtr = findRootStartTagEnd(begin, end);
+    if (!rootEndPtr)
+        return false;
+    root = (std::uint64_t) std::distance(begin, rootEndPtr);
+
+    const std::vector<const char*> starts = findUnitStarts(rootEndPtr, end, pool);
+    if (starts.empty())
+        return false;
+
+    // the last unit ends before the end tag of the root
+    const std::string_view rest(starts.back(), std::distance(starts.back(), end));
+    const std::size_t rootClose = rest.rfind("</unit");
+    if (rootClose == std::string_view::npos || rootClose == 0)
+        return false;
+
+    entries.resize(starts.size());
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+        const char* limit = i + 1 < starts.size() ? starts[i + 1] : starts.back() + rootClose;
+
+        // the unit ends at the last '>' before the next unit, skipping whitespace between units
+        const char* unitEnd = limit;
+        while (unitEnd != starts[i] && *std::prev(unitEnd) != '>')
+            --unitEnd;
+
+        Entry& entry = entries[i];
+        entry.offset = (std::uint64_t) std::distance(begin, starts[i]);
+        entry.length = (std::uint64_t) std::distance(starts[i], unitEnd);
+
+        const char* tagEnd = scanChar(starts[i], unitEnd, '>');
+        const std::string_view tag(starts[i], std::distance(starts[i], tagEnd));
+        std::string_view filename = attributeValue(tag, "filename");
+        if (filename.empty())
+            filename = attributeValue(tag, "url");
+        const std::string_view language = attributeValue(tag, "language");
+        entry.filenameOffset = (std::uint32_t) strings.size();
+        entry.filenameLength = (std::uint32_t) filename.size();
+        strings.append(filename.data(), filename.size());
+        entry.languageOffset = (std::uint32_t) strings.size();
+        entry.languageLength = (std::uint32_t) language.size();
+        strings.append(language.data(), language.size());
+    }
+
+    pool.run(entries.size(), [&](std::size_t unit, int) {
+        Entry& entry = entries[unit];
+        entry.hash = hash(std::string_view(begin + entry.offset, entry.length));
+    });
+
+    return true;
+}
+
+/*
+    Write the index file.
+
+    @param path Path of the index file
+    @return false if the file could not be written
+*/
+bool UnitIndex::save(const std::string& path) const {
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    out.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    writeValue(out, INDEX_VERSION);
+    writeValue(out, (std::uint32_t) 0);
+    writeValue(out, size);
+    writeValue(out, root);
+    writeValue(out, (std::uint64_t) entries.size());
+    writeValue(out, (std::uint64_t) strings.size());
+    out.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize) (entries.size() * sizeof(Entry)));
+    out.write(strings.data(), (std::streamsize) strings.size());
+    out.flush();
+
+    return (bool) out;
+}
+
+/*
+    Read an index file.
+
+    @param path Path of the index file
+    @return false if the file is missing, or is not a valid index
+*/
+bool UnitIndex::load(const std::string& path) {
+
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(INDEX_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), INDEX_MAGIC))
+        return false;
+
+    std::uint32_t version = 0;
+    std::uint32_t reserved = 0;
+    std::uint64_t count = 0;
+    std::uint64_t stringsSize = 0;
+    if (!readValue(in, version) || version != INDEX_VERSION || !readValue(in, reserved)
+        || !readValue(in, size) || !readValue(in, root) || !readValue(in, count) || !readValue(in, stringsSize))
+        return false;
+
+    // the entries and strings must be the rest of the file, before anything is allocated for them
+    const std::streamoff header = in.tellg();
+    if (header == -1 || !in.seekg(0, std::ios::end))
+        return false;
+    const std::streamoff fileSize = in.tellg();
+    if (fileSize < header || !in.seekg(header))
+        return false;
+    const std::uint64_t rest = (std::uint64_t) (fileSize - header);
+    if (count > rest / sizeof(Entry) || stringsSize != rest - count * sizeof(Entry) || root > size)
+        return false;
+
+    entries.resize((std::size_t) count);
+    strings.resize((std::size_t) stringsSize);
+    if (!in.read(reinterpret_cast<char*>(entries.data()), (std::streamsize) (entries.size() * sizeof(Entry)))
+        || !in.read(strings.data(), (std::streamsize) strings.size()))
+        return false;
+
+    // every range must be in the archive and in the strings, written so that no sum can overflow
+    for (const Entry& entry : entries) {
+        if (entry.offset > size || entry.length > size - entry.offset
+            || (std::uint64_t) entry.filenameOffset + entry.filenameLength > stringsSize
+            || (std::uint64_t) entry.languageOffset + entry.languageLength > stringsSize)
+            return false;
+    }
+
+    return true;
+}
+
+// units, in the order of the archive
+const std::vector<UnitIndex::Entry>& UnitIndex::units() const {
+
+    return entries;
+}
+
+// filename attribute of a unit, or the url if there is no filename
+std::string_view UnitIndex::filename(const Entry& entry) const {
+
+    return std::string_view(strings.data() + entry.filenameOffset, entry.filenameLength);
+}
+
+// language attribute of a unit
+std::string_view UnitIndex::language(const Entry& entry) const {
+
+    return std::string_view(strings.data() + entry.languageOffset, entry.languageLength);
+}
+
+// size of the indexed archive
+std::uint64_t UnitIndex::inputSize() const {
+
+    return size;
+}
+
+// offset just past the root start tag
+std::uint64_t UnitIndex::rootEnd() const {
+
+    return root;
+}
+
+/*
+    Units with a filename that matches any of the patterns. A pattern
+    is an exact filename, or a glob where '*' also matches '/', so
+    "src/" followed by '*' selects a whole directory.
+
+    @param patterns Filenames or globs
+    @return Matching units, in the order of the archive
+*/
+std::vector<UnitIndex::Entry> UnitIndex::select(const std::vector<std::string>& patterns) const {
+
+    std::vector<Entry> selected;
+    std::string name;
+    for (const Entry& entry : entries) {
+        name.assign(filename(entry));
+        for (const auto& pattern : patterns) {
+#if !defined(_MSC_VER)
+            const bool match = pattern == name || fnmatch(pattern.c_str(), name.c_str(), 0) == 0;
+#else
+            const bool match = pattern == name;
+#endif
+            if (match) {
+                selected.push_back(entry);
+                break;
+            }
+        }
+    }
+
+    return selected;
+}
+
+// FNV-1a 64-bit hash of the bytes of a unit
+std::uint64_t UnitIndex::hash(std::string_view bytes) {
+
+    return fnvHash64(bytes);
+}
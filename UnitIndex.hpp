@@ -0,0 +1,71 @@
+/*
+    UnitIndex.hpp
+
+    Declaration of a sidecar index of the units of a srcML archive
+*/
+
+#ifndef INCLUDE_UNITINDEX_HPP
+#define INCLUDE_UNITINDEX_HPP
+
+#include "WorkStealingPool.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class UnitIndex {
+public:
+
+    // a file unit of the archive
+    struct Entry {
+        // range of the unit, from '<' of the start tag to '>' of the end tag
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+        // hash of the bytes of the unit
+        std::uint64_t hash = 0;
+        // position of the attribute values in the strings
+        std::uint32_t filenameOffset = 0;
+        std::uint32_t filenameLength = 0;
+        std::uint32_t languageOffset = 0;
+        std::uint32_t languageLength = 0;
+    };
+
+    // build the index of an archive in memory
+    bool build(const char* begin, const char* end, WorkStealingPool& pool);
+
+    // write the index file
+    bool save(const std::string& path) const;
+
+    // read an index file, returning false if it is missing or invalid
+    bool load(const std::string& path);
+
+    // units, in the order of the archive
+    const std::vector<Entry>& units() const;
+
+    // filename attribute of a unit, or the url if there is no filename
+    std::string_view filename(const Entry& entry) const;
+
+    // language attribute of a unit
+    std::string_view language(const Entry& entry) const;
+
+    // size of the indexed archive
+    std::uint64_t inputSize() const;
+
+    // offset just past the root start tag
+    std::uint64_t rootEnd() const;
+
+    // units with a filename equal to, or matching the glob of, any pattern
+    std::vector<Entry> select(const std::vector<std::string>& patterns) const;
+
+    // hash of the bytes of a unit
+    static std::uint64_t hash(std::string_view bytes);
+
+private:
+    std::vector<Entry> entries;
+    // attribute values of all units, each referred to by offset
+    std::string strings;
+    std::uint64_t size = 0;
+    std::uint64_t root = 0;
+};
+
+#endif
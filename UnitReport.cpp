@@ -0,0 +1,196 @@
+/*
+    UnitReport.cpp
+
+    Implement a per-unit report of facts, as NDJSON or CSV
+
+    Each thread appends records to its own batch, which is written to
+    the report with a single write when it grows past BATCH_SIZE, so
+    memory stays constant however many units there are. Numbers are
+    formatted in place with std::to_chars, so adding a record does
+    not allocate once the batch has grown.
+ */
+
+#include "UnitReport.hpp"
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <errno.h>
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#define WRITE ::write
+#else
+#include <BaseTsd.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#define WRITE ::_write
+#endif
+
+namespace {
+
+const std::size_t BATCH_SIZE = 1024 * 1024;
+
+// column names, in the order of the UnitCounts fields
+const char* const COLUMNS[] = { "loc", "characters", "classes", "functions", "declarations",
+    "expressions", "comments", "returns", "literals", "line_comments" };
+
+// append a number
+void appendNumber(std::string& out, long value) {
+
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+// append a JSON string, escaping quotes, backslashes, and control characters
+void appendJSONString(std::string& out, std::string_view s) {
+
+    out += '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char) c < 0x20) {
+            static const char HEX[] = "0123456789abcdef";
+            out += "\\u00";
+            out += HEX[(c >> 4) & 0xf];
+            out += HEX[c & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+// append a CSV field, quoted if it contains a delimiter, quote, or line break
+void appendCSVField(std::string& out, std::string_view s) {
+
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out += s;
+        return;
+    }
+    out += '"';
+    for (char c : s) {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+}
+
+/*
+    Format from its name.
+
+    @param name Name of the format, ndjson or csv
+    @param format Set to the format
+    @return false for an unknown name
+*/
+bool UnitReport::parseFormat(std::string_view name, Format& format) {
+
+    if (name == "ndjson") {
+        format = NDJSON;
+        return true;
+    }
+    if (name == "csv") {
+        format = CSV;
+        return true;
+    }
+
+    return false;
+}
+
+// constructor, writing the CSV header
+UnitReport::UnitReport(Format format, int fd)
+    : format(format), fd(fd)
+{
+    if (format != CSV)
+        return;
+
+    std::string header = "filename";
+    for (const char* column : COLUMNS) {
+        header += ',';
+        header += column;
+    }
+    header += '\n';
+    write(header);
+}
+
+/*
+    Write the bytes to the report. Batches from different threads
+    are written whole, one after the other.
+
+    @param data Bytes to write
+*/
+void UnitReport::write(std::string_view data) {
+
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!data.empty()) {
+        const ssize_t numbytes = WRITE(fd, data.data(), data.size());
+        if (numbytes == -1 && errno == EINTR)
+            continue;
+        if (numbytes <= 0) {
+            std::cerr << "srcFacts: Unable to write unit report\n";
+            exit(1);
+        }
+        data.remove_prefix((std::size_t) numbytes);
+    }
+}
+
+// constructor
+UnitReport::Batch::Batch(UnitReport& report)
+    : report(report)
+{
+    records.reserve(BATCH_SIZE + 4096);
+}
+
+// destructor, writing any remaining records
+UnitReport::Batch::~Batch() {
+
+    flush();
+}
+
+/*
+    Add the record of a unit, writing the batch when it is full.
+
+    @param key Filename, or url, of the unit
+    @param counts Counts of the unit
+*/
+void UnitReport::Batch::add(std::string_view key, const UnitCounts& counts) {
+
+    const long values[] = { counts.loc, counts.characters, counts.classes, counts.functions, counts.declarations,
+        counts.expressions, counts.comments, counts.returns, counts.literals, counts.line_comments };
+
+    if (report.format == NDJSON) {
+        records += "{\"filename\":";
+        appendJSONString(records, key);
+        for (std::size_t i = 0; i < std::size(values); ++i) {
+            records += ",\"";
+            records += COLUMNS[i];
+            records += "\":";
+            appendNumber(records, values[i]);
+        }
+        records += "}\n";
+    } else {
+        appendCSVField(records, key);
+        for (long value : values) {
+            records += ',';
+            appendNumber(records, value);
+        }
+        records += '\n';
+    }
+
+    if (records.size() >= BATCH_SIZE)
+        flush();
+}
+
+// write the records to the report
+void UnitReport::Batch::flush() {
+
+    if (records.empty())
+        return;
+
+    report.write(records);
+    records.clear();
+}
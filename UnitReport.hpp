@@ -0,0 +1,76 @@
+/*
+    UnitReport.hpp
+
+    Declaration of a per-unit report of facts, as NDJSON or CSV
+*/
+
+#ifndef INCLUDE_UNITREPORT_HPP
+#define INCLUDE_UNITREPORT_HPP
+
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// counts of one unit, in the order of the report columns
+struct UnitCounts {
+    long loc = 0;
+    long characters = 0;
+    long classes = 0;
+    long functions = 0;
+    long declarations = 0;
+    long expressions = 0;
+    long comments = 0;
+    long returns = 0;
+    long literals = 0;
+    long line_comments = 0;
+};
+
+class UnitReport {
+public:
+
+    // formats of the report
+    enum Format { NDJSON, CSV };
+
+    // format from its name, returning false for an unknown name
+    static bool parseFormat(std::string_view name, Format& format);
+
+    // constructor, writing the CSV header
+    explicit UnitReport(Format format, int fd = 1);
+
+    UnitReport(const UnitReport&) = delete;
+    UnitReport& operator=(const UnitReport&) = delete;
+
+    // records of one thread, written to the report in large batches
+    class Batch {
+    public:
+
+        // constructor
+        explicit Batch(UnitReport& report);
+
+        // destructor, writing any remaining records
+        ~Batch();
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+        // add the record of a unit
+        void add(std::string_view key, const UnitCounts& counts);
+
+        // write the records to the report
+        void flush();
+
+    private:
+        UnitReport& report;
+        std::string records;
+    };
+
+private:
+    // write the bytes, one batch at a time
+    void write(std::string_view data);
+
+    Format format;
+    int fd;
+    std::mutex mutex;
+};
+
+#endif
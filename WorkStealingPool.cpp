@@ -0,0 +1,96 @@
+/*
+    WorkStealingPool.cpp
+
+    Implement a work-stealing pool of threads
+
+    Tasks are dealt round-robin onto one queue per worker, so tasks
+    given in decreasing order of size start largest-first. A worker
+    takes tasks from the front of its own queue. When its queue is
+    empty it steals from the front of another worker's queue, so a
+    thief also takes the largest task left, and no worker is left idle
+    while another has a backlog. Stealing from the back would leave the
+    largest remaining tasks queued behind a busy worker.
+ */
+
+#include "WorkStealingPool.hpp"
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// queue of task indices for one worker
+struct TaskQueue {
+    std::mutex mutex;
+    std::deque<std::size_t> tasks;
+};
+
+}
+
+// constructor
+WorkStealingPool::WorkStealingPool(int threads)
+    : threads(threads > 0 ? threads : 1)
+{}
+
+// number of workers
+int WorkStealingPool::size() const {
+
+    return threads;
+}
+
+/*
+    Run a task for every index in [0, count). The calling thread is
+    worker 0. Returns once all tasks are done.
+
+    @param count Number of tasks
+    @param task Called with the task index and the worker number
+*/
+void WorkStealingPool::run(std::size_t count, const std::function<void(std::size_t, int)>& task) {
+
+    std::vector<TaskQueue> queues(threads);
+    for (std::size_t i = 0; i < count; ++i)
+        queues[i % threads].tasks.push_back(i);
+
+    auto worker = [&](int self) {
+
+        while (true) {
+
+            // next task from the front of our own queue
+            bool found = false;
+            std::size_t index = 0;
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if (!queues[self].tasks.empty()) {
+                    index = queues[self].tasks.front();
+                    queues[self].tasks.pop_front();
+                    found = true;
+                }
+            }
+
+            // otherwise steal the largest task left, from the front of another queue
+            for (int offset = 1; !found && offset < threads; ++offset) {
+                TaskQueue& victim = queues[(self + offset) % threads];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    index = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    found = true;
+                }
+            }
+
+            // no task is queued anywhere, and tasks never add tasks
+            if (!found)
+                return;
+
+            task(index, self);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; ++i)
+        workers.emplace_back(worker, i);
+    worker(0);
+    for (auto& t : workers)
+        t.join();
+}
@@ -0,0 +1,29 @@
+/*
+    WorkStealingPool.hpp
+
+    Declaration of a work-stealing pool of threads
+*/
+
+#ifndef INCLUDE_WORKSTEALINGPOOL_HPP
+#define INCLUDE_WORKSTEALINGPOOL_HPP
+
+#include <cstddef>
+#include <functional>
+
+class WorkStealingPool {
+public:
+
+    // constructor
+    explicit WorkStealingPool(int threads);
+
+    // number of workers
+    int size() const;
+
+    // run task(index, worker) for every index in [0, count), returning when all are done
+    void run(std::size_t count, const std::function<void(std::size_t, int)>& task);
+
+private:
+    int threads;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+    XMLCursor.cpp
+
+    Implementation file for a pull parser over XMLParserBase
+
+    next() parses one part of the XML with parseNext(), and the handlers
+    below store its tokens instead of acting on them. A part has one
+    token, except for the XML declaration, which has one for the
+    declaration and one for each of its attributes. A CDATA section or
+    comment larger than the buffer is passed by parseNext() one chunk
+    per call, so each chunk is a part of its own, and its view is valid
+    until the refill of the next call.
+ */
+
+#include "XMLCursor.hpp"
+
+// constructor, reading standard input
+XMLCursor::XMLCursor(bool asyncRead)
+    : XMLParserBase(asyncRead)
+{}
+
+// constructor, reading a source, e.g., a file path
+XMLCursor::XMLCursor(InputSource source, bool asyncRead)
+    : XMLParserBase(std::move(source), asyncRead)
+{}
+
+// constructor over input already in memory
+XMLCursor::XMLCursor(const char* begin, const char* end, int depth)
+    : XMLParserBase(begin, end, depth)
+{}
+
+/*
+    Next token, parsing the next part of the XML when the tokens of the
+    current part are used up.
+
+    @return The token, valid until the next call, or END_OF_INPUT at the end
+*/
+const XMLToken& XMLCursor::next() {
+
+    if (current + 1 < count)
+        return tokens[++current];
+
+    count = 0;
+    current = 0;
+    while (count == 0) {
+        partOffset = offset();
+        if (!parseNext())
+            push(XMLToken::END_OF_INPUT, std::string_view(), std::string_view(), depth);
+    }
+    if (tokens[0].kind == XMLToken::START_TAG)
+        startDepth = tokens[0].depth;
+
+    return tokens[0];
+}
+
+/*
+    Skip the rest of the element of the last start tag, through its
+    end tag. Call it after next() returns the start tag, or any of its
+    attributes, e.g., to skip the body of a function. Nothing is
+    skipped if the element has already ended, e.g., an empty element.
+*/
+void XMLCursor::skipSubtree() {
+
+    if (startDepth == -1)
+        return;
+
+    skipElement(startDepth);
+    startDepth = -1;
+    count = 0;
+    current = 0;
+}
+
+// add a token of the current part
+void XMLCursor::push(XMLToken::Kind kind, std::string_view name, std::string_view value, int depth, ElementID id, NamespaceID ns) {
+
+    XMLToken& token = tokens[count++];
+    token.kind = kind;
+    token.name = name;
+    token.value = value;
+    token.depth = depth;
+    token.offset = partOffset;
+    token.id = id;
+    token.ns = ns;
+}
+
+// handle a XML declaration
+void XMLCursor::handleDeclaration(std::string_view target) {
+
+    push(XMLToken::DECLARATION, target, std::string_view(), depth);
+}
+
+// handle a XML required version
+void XMLCursor::handleRequiredVersion(std::string_view version) {
+
+    push(XMLToken::REQUIRED_VERSION, "version", version, depth);
+}
+
+// handle a XML encoding
+void XMLCursor::handleEncoding(std::string_view encoding) {
+
+    push(XMLToken::ENCODING, "encoding", encoding, depth);
+}
+
+// handle a XML standalone
+void XMLCursor::handleStandalone(std::string_view standalone) {
+
+    push(XMLToken::STANDALONE, "standalone", standalone, depth);
+}
+
+// handle a XML end tag, after the depth is decreased
+void XMLCursor::handleEndTag(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID ns) {
+
+    push(XMLToken::END_TAG, qname, std::string_view(), depth, id, ns);
+}
+
+// handle a XML start tag, before the depth is increased
+void XMLCursor::handleStartTag(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID ns) {
+
+    push(XMLToken::START_TAG, qname, std::string_view(), depth, id, ns);
+}
+
+// handle a XML namespace, in a start tag
+void XMLCursor::handleNameSpace(std::string_view prefix, std::string_view uri) {
+
+    push(XMLToken::NAMESPACE, prefix, uri, depth - 1);
+}
+
+// handle a XML attribute, in a start tag
+void XMLCursor::handleAttribute(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, std::string_view value, NamespaceID ns) {
+
+    push(XMLToken::ATTRIBUTE, qname, value, depth - 1, (ElementID) -1, ns);
+}
+
+// handle a XML CDATA
+void XMLCursor::handleCDATA(std::string_view characters) {
+
+    push(XMLToken::CDATA, std::string_view(), characters, depth);
+}
+
+// handle a XML comment
+void XMLCursor::handleComment(std::string_view comment) {
+
+    push(XMLToken::COMMENT, std::string_view(), comment, depth);
+}
+
+// handle a XML characters before or after XML
+void XMLCursor::handleCharactersBeforeOrAfter(std::string_view characters) {
+
+    push(XMLToken::CHARACTERS_BEFORE_OR_AFTER, std::string_view(), characters, depth);
+}
+
+// handle a XML entity reference
+void XMLCursor::handleEntityReference(std::string_view characters) {
+
+    push(XMLToken::ENTITY_REFERENCE, std::string_view(), characters, depth);
+}
+
+// handle a XML characters
+void XMLCursor::handleCharacters(std::string_view characters) {
+
+    push(XMLToken::CHARACTERS, std::string_view(), characters, depth);
+}
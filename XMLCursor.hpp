@@ -0,0 +1,123 @@
+/*
+    XMLCursor.hpp
+
+    Declaration file for a pull parser over XMLParserBase
+
+    Instead of handlers called by parse(), the caller asks for one token
+    at a time with next(). E.g., to look at function signatures only:
+
+        XMLCursor cursor;
+        for (auto token = &cursor.next(); token->kind != XMLToken::END_OF_INPUT; token = &cursor.next()) {
+            if (token->kind == XMLToken::START_TAG && token->id == ELEMENT_BLOCK)
+                cursor.skipSubtree();
+        }
+
+    Token views are into the input buffer, so they are only valid until
+    the next call to next() or skipSubtree(). keep() copies a value into
+    the arena of the parser, valid until the next unit end tag token.
+    A CDATA section or comment larger than the buffer is several tokens
+    of its kind, one for each chunk.
+ */
+
+#ifndef INCLUDED_XMLCURSOR_HPP
+#define INCLUDED_XMLCURSOR_HPP
+
+#include "XMLParserBase.hpp"
+#include <array>
+#include <string_view>
+
+// a part of the XML
+struct XMLToken {
+
+    // kinds of tokens, in the order of the handlers
+    enum Kind { DECLARATION, REQUIRED_VERSION, ENCODING, STANDALONE, END_TAG, START_TAG, NAMESPACE, ATTRIBUTE,
+                CDATA, COMMENT, CHARACTERS_BEFORE_OR_AFTER, ENTITY_REFERENCE, CHARACTERS, END_OF_INPUT };
+
+    Kind kind = END_OF_INPUT;
+    // qualified name of a tag or attribute, prefix of a namespace, or target of a declaration
+    std::string_view name;
+    // value of an attribute or declaration attribute, URI of a namespace, or the characters
+    std::string_view value;
+    // depth of the element, for tags, namespaces, and attributes, or of the content, for characters
+    int depth = 0;
+    // offset in the input of the start of the token
+    long offset = 0;
+    // element name ID of a tag, or -1
+    ElementID id = (ElementID) -1;
+    // namespace ID of a tag or attribute
+    NamespaceID ns = NAMESPACE_NONE;
+};
+
+class XMLCursor : public XMLParserBase<XMLCursor> {
+public:
+
+    // constructor, reading standard input
+    explicit XMLCursor(bool asyncRead = false);
+
+    // constructor, reading a source, e.g., a file path
+    explicit XMLCursor(InputSource source, bool asyncRead = false);
+
+    // constructor over input already in memory
+    XMLCursor(const char* begin, const char* end, int depth = 0);
+
+    // next token, END_OF_INPUT at the end
+    const XMLToken& next();
+
+    // skip the rest of the element of the last start tag, through its end tag
+    void skipSubtree();
+
+// handle a XML declaration
+void handleDeclaration(std::string_view target);
+
+// handle a XML required version
+void handleRequiredVersion(std::string_view version);
+
+// handle a XML encoding
+void handleEncoding(std::string_view encoding);
+
+// handle a XML standalone
+void handleStandalone(std::string_view standalone);
+
+// handle a XML end tag
+void handleEndTag(std::string_view qname, std::string_view prefix, std::string_view local_name, ElementID id, NamespaceID ns);
+
+// handle a XML start tag
+void handleStartTag(std::string_view qname, std::string_view prefix, std::string_view local_name, ElementID id, NamespaceID ns);
+
+// handle a XML namespace
+void handleNameSpace(std::string_view prefix, std::string_view uri);
+
+// handle a XML attribute
+void handleAttribute(std::string_view qname, std::string_view prefix, std::string_view local_name, std::string_view value, NamespaceID ns);
+
+// handle a XML CDATA
+void handleCDATA(std::string_view characters);
+
+// handle a XML comment
+void handleComment(std::string_view comment);
+
+// handle a XML characters before or after XML
+void handleCharactersBeforeOrAfter(std::string_view characters);
+
+// handle a XML entity reference
+void handleEntityReference(std::string_view characters);
+
+// handle a XML characters
+void handleCharacters(std::string_view characters);
+
+private:
+    // add a token of the current part
+    void push(XMLToken::Kind kind, std::string_view name, std::string_view value, int depth,
+              ElementID id = (ElementID) -1, NamespaceID ns = NAMESPACE_NONE);
+
+    // tokens of the current part, at most four for a declaration
+    std::array<XMLToken, 4> tokens;
+    int count = 0;
+    int current = 0;
+    // offset of the current part
+    long partOffset = 0;
+    // depth of the element of the last start tag, or -1
+    int startDepth = -1;
+};
+
+#endif
@@ -1,19 +1,12 @@
 /*
     XMLParser.cpp
- 
-    Implementation file for XML parsing class
+
+    Implementation file for XML parsing class with std::function handlers
  */
 
 #include "XMLParser.hpp"
-#include "refillBuffer.hpp"
-
-#include <iostream>
-#include <iterator>
-#include <sstream>
 
-const int XMLNS_SIZE = strlen("xmlns");
-
-// constructor
+// constructor, reading standard input
 XMLParser::XMLParser(std::function<void(const std::string&)>handleDeclarations,
                      std::function<void(const std::string&)>handleRequiredVersion,
                      std::function<void(const std::string&)>handleEncoding,
@@ -27,564 +20,121 @@ XMLParser::XMLParser(std::function<void(const std::string&)>handleDeclarations,
                      std::function<void(const std::string&)>handleCharactersBeforeOrAfter,
                      std::function<void(const std::string&)>handleEntityReferences,
                      std::function<void(const std::string&)>handleCharacters)
-   : handleDeclarations(handleDeclarations), handleRequiredVersion(handleRequiredVersion),
-     handleEncoding(handleEncoding), handleStandalones(handleStandalones),
-     handleEndTags(handleEndTags), handleStartTags(handleStartTags), handleNameSpaces(handleNameSpaces),
-     handleAttributes(handleAttributes), handleCDATA(handleCDATA), handleComments(handleComments),
-     handleCharactersBeforeOrAfter(handleCharactersBeforeOrAfter), handleEntityReferences(handleEntityReferences),
-     handleCharacters(handleCharacters)
-{
-    pc = buffer.cbegin();
-    pc = refillBuffer(pc, buffer, total);
-}
+   : XMLParser(InputSource::fromFD(0), handleDeclarations, handleRequiredVersion, handleEncoding, handleStandalones,
+               handleEndTags, handleStartTags, handleNameSpaces, handleAttributes, handleCDATA, handleComments,
+               handleCharactersBeforeOrAfter, handleEntityReferences, handleCharacters)
+{}
+
+// constructor, reading a source, e.g., a file path
+XMLParser::XMLParser(InputSource source,
+                     std::function<void(const std::string&)>handleDeclarations,
+                     std::function<void(const std::string&)>handleRequiredVersion,
+                     std::function<void(const std::string&)>handleEncoding,
+                     std::function<void(const std::string&)>handleStandalones,
+                     std::function<void(const std::string&)>handleEndTags,
+                     std::function<void(const std::string&)>handleStartTags,
+                     std::function<void(const std::string&)>handleNameSpaces,
+                     std::function<void(const std::string&)>handleAttributes,
+                     std::function<void(const std::string&)>handleCDATA,
+                     std::function<void(const std::string&)>handleComments,
+                     std::function<void(const std::string&)>handleCharactersBeforeOrAfter,
+                     std::function<void(const std::string&)>handleEntityReferences,
+                     std::function<void(const std::string&)>handleCharacters)
+   : XMLParserBase(std::move(source)), declarationHandler(handleDeclarations), requiredVersionHandler(handleRequiredVersion),
+     encodingHandler(handleEncoding), standaloneHandler(handleStandalones),
+     endTagHandler(handleEndTags), startTagHandler(handleStartTags), nameSpaceHandler(handleNameSpaces),
+     attributeHandler(handleAttributes), CDATAHandler(handleCDATA), commentHandler(handleComments),
+     charactersBeforeOrAfterHandler(handleCharactersBeforeOrAfter), entityReferenceHandler(handleEntityReferences),
+     charactersHandler(handleCharacters)
+{}
 
-// parse the XML
-void XMLParser::parse() {
-    
-    while (true) {
-        if (std::distance(pc, buffer.cend()) < 5) {
-            // refill buffer and adjust iterator
-            pc = refillBuffer(pc, buffer, total);
-            if (isDone())
-                break;
-        } else if (isXMLDeclaration()) {
-            // parse XML declaration
-            std::string name;
-            parseDeclaration(name);
-            // parse required version
-            parseRequiredVersion();
-             //parse encoding
-            parseEncoding();
-            //parse standalone
-            parseStandalone();
-        } else if (isXMLEndTag()) {
-            std::string local_name;
-            std::string qname;
-            std::string prefixbase;
-            // parse end tag
-            parseEndTag();
-        } else if (isXMLStartTag()) {
-            std::string local_name;
-            std::string qname;
-            std::string prefixbase;
-            // parse start tag
-            parseStartTag();
-        } else if (isXMLNamespace()) {
-            // parse namespace
-            parseNameSpace();
-        } else if (isXMLAttribute()) {
-            // parse attribute
-            parseAttribute();
-        } else if (isXMLCDATA()) {
-            // parse CDATA
-            parseCDATA();
-        } else if (isXMLComment()) {
-            // parse XML comment
-            parseComment();
-        } else if (isCharactersBeforeOrAfter()) {
-             // parse characters before or after XML
-            parseCharactersBeforeOrAfter();
-        } else if (isXMLEntityCharacters()) {
-            // parse entity references
-            std::string characters;
-            parseEntityReference(characters);
-        } else if (isXMLCharacters()) {
-            // parse characters
-            parseCharacters();
-        }
-    }
-}
+// handle a XML declaration
+void XMLParser::handleDeclaration(std::string_view target) {
 
-// is done parsing
-bool XMLParser::isDone() {
-    
-    return pc == buffer.cend();
+    if (declarationHandler != nullptr)
+        declarationHandler(std::string(target));
 }
 
-// is parsing at a XML declaration
-bool XMLParser::isXMLDeclaration() {
-  
-    return *pc == '<' && *std::next(pc) == '?';
-
-}
+// handle a XML required version
+void XMLParser::handleRequiredVersion(std::string_view version) {
 
-// is parsing at a XML end tag
-bool XMLParser::isXMLEndTag() {
-    
-    return *pc == '<' && *std::next(pc) == '/';
+    if (requiredVersionHandler != nullptr)
+        requiredVersionHandler(std::string(version));
 }
 
-// is parsing at a XML start tag
-bool XMLParser::isXMLStartTag() {
-    
-    return *pc == '<' && *std::next(pc) != '/' && *std::next(pc) != '?';
+// handle a XML encoding
+void XMLParser::handleEncoding(std::string_view encoding) {
 
+    if (encodingHandler != nullptr)
+        encodingHandler(std::string(encoding));
 }
 
-// is parsing at a XML namespace
-bool XMLParser::isXMLNamespace() {
-    
-    return intag && *pc != '>' && *pc != '/' && std::distance(pc, buffer.cend()) > (int) XMLNS_SIZE && std::string(pc, std::next(pc, XMLNS_SIZE)) == "xmlns"
-    && (*std::next(pc, XMLNS_SIZE) == ':' || *std::next(pc, XMLNS_SIZE) == '=');
-}
+// handle a XML standalone
+void XMLParser::handleStandalone(std::string_view standalone) {
 
-// is parsing at a XML attribute
-bool XMLParser::isXMLAttribute() {
-    
-    return intag && *pc != '>' && *pc != '/';
+    if (standaloneHandler != nullptr)
+        standaloneHandler(std::string(standalone));
 }
 
-// is parsing at a XML CDATA
-bool XMLParser::isXMLCDATA() {
-    
-    return *pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '[';
-}
+// handle a XML end tag
+void XMLParser::handleEndTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view local_name, ElementID /* id */, NamespaceID /* ns */) {
 
-// is parsing at a XML comment
-bool XMLParser::isXMLComment() {
-    
-    return *pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '-' && *std::next(pc, 3) == '-';
+    if (endTagHandler != nullptr)
+        endTagHandler(std::string(local_name));
 }
 
-// is parsing at characters before or after XML
-bool XMLParser::isCharactersBeforeOrAfter() {
-    
-    return *pc != '<' && depth == 0;
-}
+// handle a XML start tag
+void XMLParser::handleStartTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view local_name, ElementID /* id */, NamespaceID /* ns */) {
 
-// is parsing at a XML entity characters
-bool XMLParser::isXMLEntityCharacters() {
-    
-    return *pc == '&';
+    if (startTagHandler != nullptr)
+        startTagHandler(std::string(local_name));
 }
 
-// is parsing at a XML characters
-bool XMLParser::isXMLCharacters() {
-    
-    return *pc != '<';
-}
+// handle a XML namespace
+void XMLParser::handleNameSpace(std::string_view /* prefix */, std::string_view uri) {
 
-// parse declaration
-void XMLParser::parseDeclaration(std::string& name) {
-     
-    if(handleDeclarations != nullptr){
-        handleDeclarations(local_name);
-    }
-    //check for incomplete XML declaration
-    if (endpc == buffer.cend()) {
-       //refill the buffer
-        name.assign(pc, endpc);
-       pc = refillBuffer(pc, buffer, total);
-       endpc = std::find(pc, buffer.cend(), '>');
-       if (endpc == buffer.cend()) {
-           std::cerr << "parser error: Incomplete XML declaration\n";
-           exit(1);
-       }
-     }
-     std::advance(pc, strlen("<?xml"));
-     pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
+    if (nameSpaceHandler != nullptr)
+        nameSpaceHandler(std::string(uri));
 }
 
-// parse required version
-void XMLParser::parseRequiredVersion() {
-    
-    if(handleRequiredVersion != nullptr){
-        handleRequiredVersion(local_name);
-    }
-    if (pc == endpc) {
-        std::cerr << "parser error: Missing space after before version in XML declaration\n";
-        exit(1);
-        }
-    std::string::const_iterator pnameend = std::find(pc, endpc, '=');
-    const std::string attr(pc, pnameend);
-    pc = pnameend;
-    std::advance(pc, 1);
-    char delim = *pc;
-    if (delim != '"' && delim != '\'') {
-        std::cerr << "parser error: Invalid start delimiter for version in XML declaration\n";
-        exit(1);
-        }
-        std::advance(pc, 1);
-    std::string::const_iterator pvalueend = std::find(pc, endpc, delim);
-    if (pvalueend == endpc) {
-        std::cerr << "parser error: Invalid end delimiter for version in XML declaration\n";
-        exit(1);
-        }
-    if (attr != "version") {
-        std::cerr << "parser error: Missing required first attribute version in XML declaration\n";
-        exit(1);
-        }
-    const std::string version(pc, pvalueend);
-    pc = std::next(pvalueend);
-    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
+// handle a XML attribute
+void XMLParser::handleAttribute(std::string_view /* qname */, std::string_view /* prefix */, std::string_view local_name, std::string_view /* value */, NamespaceID /* ns */) {
 
+    if (attributeHandler != nullptr)
+        attributeHandler(std::string(local_name));
 }
 
-// parse a XML encoding
-void XMLParser::parseEncoding() {
-    
-    if(handleEncoding != nullptr){
-        handleEncoding(local_name);
-    }
-    if (pc == endpc) {
-        std::cerr << "parser error: Missing required encoding in XML declaration\n";
-        exit(1);
-    }
-    std::string::const_iterator pnameend = std::find(pc, endpc, '=');
-    if (pnameend == endpc) {
-        std::cerr << "parser error: Incomple encoding in XML declaration\n";
-        exit(1);
-    }
-    const std::string attr2(pc, pnameend);
-    pc = pnameend;
-    std::advance(pc, 1);
-    char delim2 = *pc;
-    if (delim2 != '"' && delim2 != '\'') {
-        std::cerr << "parser error: Invalid end delimiter for encoding in XML declaration\n";
-        exit(1);
-    }
-    std::advance(pc, 1);
-    std::string::const_iterator pvalueend = std::find(pc, endpc, delim2);
-    if (pvalueend == endpc) {
-        std::cerr << "parser error: Incomple encoding in XML declaration\n";
-        exit(1);
-    }
-    if (attr2 != "encoding") {
-         std::cerr << "parser error: Missing required encoding in XML declaration\n";
-        exit(1);
-    }
-    const std::string encoding(pc, pvalueend);
-    pc = std::next(pvalueend);
-    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
-}
+// handle a XML CDATA
+void XMLParser::handleCDATA(std::string_view characters) {
 
-// parse a XML standalone
-void XMLParser::parseStandalone() {
-    
-    if(handleStandalones != nullptr){
-        handleStandalones(local_name);
-    }
-    if (pc == endpc) {
-        std::cerr << "parser error: Missing required third attribute standalone in XML declaration\n";
-        exit(1);
-    }
-    std::string::const_iterator pnameend = std::find(pc, endpc, '=');
-    const std::string attr3(pc, pnameend);
-    pc = pnameend;
-    std::advance(pc, 1);
-    char delim3 = *pc;
-    if (delim3 != '"' && delim3 != '\'') {
-        std::cerr << "parser error : Missing attribute standalone delimiter in XML declaration\n";
-        exit(1);
-    }
-    std::advance(pc, 1);
-    std::string::const_iterator pvalueend = std::find(pc, endpc, delim3);
-    if (pvalueend == endpc) {
-        std::cerr << "parser error : Missing attribute standalone in XML declaration\n";
-        exit(1);
-    }
-    if (attr3 != "standalone") {
-        std::cerr << "parser error : Missing attribute standalone in XML declaration\n";
-        exit(1);
-    }
-    const std::string standalone(pc, pvalueend);
-    pc = std::next(pvalueend);
-    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
-    std::advance(pc, strlen("?>"));
-    pc = std::find_if_not(pc, buffer.cend(), [] (char c) { return isspace(c); });
+    if (CDATAHandler != nullptr)
+        CDATAHandler(std::string(characters));
 }
 
-// parse a XML end tag
-void XMLParser::parseEndTag() {
-    
-    if(handleEndTags != nullptr){
-        handleEndTags(local_name);
-    }
-    --depth;
-    std::string::const_iterator endpc = std::find(pc, buffer.cend(), '>');
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::find(pc, buffer.cend(), '>');
-        if (endpc == buffer.cend()) {
-            std::cerr << "parser error: Incomplete element end tag\n";
-            exit(1);
-        }
-    }
-    std::advance(pc, 2);
-    std::string::const_iterator pnameend = std::find_if(pc, std::next(endpc), [] (char c) { return isspace(c) || c == '>' || c == '/'; });
-    if (pnameend == std::next(endpc)) {
-          std::cerr << "parser error: Incomplete element end tag name\n";
-          exit(1);
-    }
-    const std::string qname(pc, pnameend);
-    const auto colonpos = qname.find(':');
-    std::string prefixbase;
-    if (colonpos != std::string::npos)
-        prefixbase = qname.substr(0, colonpos);
-    const std::string prefix = std::move(prefixbase);
-    std::string local_namebase;
-    if (colonpos != std::string::npos)
-        local_namebase = qname.substr(colonpos + 1);
-    else
-        local_namebase = qname;
-    const std::string local_name = std::move(local_namebase);
-    pc = std::next(endpc);
-}
-
-// parse a XML start tag
-void XMLParser::parseStartTag() {
-    
-    if(handleStartTags != nullptr){
-        handleStartTags(local_name);
-    }
-    endpc = std::find(pc, buffer.cend(), '>');
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::find(pc, buffer.cend(), '>');
-        if (endpc == buffer.cend()) {
-            std::cerr << "parser error: Incomplete element start tag\n";
-            exit(1);
-        }
-    }
-    std::advance(pc, 1);
-    std::string::const_iterator pnameend = std::find_if(pc, std::next(endpc), [] (char c) { return isspace(c) || c == '>' || c == '/'; });
-    if (pnameend == std::next(endpc)) {
-        std::cerr << "parser error : Unterminated start tag '" << std::string(pc, pnameend) << "'\n";
-        exit(1);
-    }
-    const std::string qname(pc, pnameend);
-    const auto colonpos = qname.find(':');
-    std::string prefixbase;
-    if (colonpos != std::string::npos)
-        prefixbase = qname.substr(0, colonpos);
-    const std::string prefix = std::move(prefixbase);
-    std::string local_namebase;
-    if (colonpos != std::string::npos)
-        local_namebase = qname.substr(colonpos + 1);
-    else
-        local_namebase = qname;
-    //const std::string
-    local_name = std::move(local_namebase);
-    pc = pnameend;
-    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
-    ++depth;
-    intag = true;
-    if (intag && *pc == '>') {
-        std::advance(pc, 1);
-        intag = false;
-    }
-    if (intag && *pc == '/' && *std::next(pc) == '>') {
-        std::advance(pc, 2);
-        intag = false;
-        --depth;
-    }
-}
+// handle a XML comment
+void XMLParser::handleComment(std::string_view comment) {
 
-// parse a XML namespace
-void XMLParser::parseNameSpace() {
-    
-    if(handleNameSpaces != nullptr){
-        handleNameSpaces(local_name);
-    }
-    std::string::const_iterator endpc = std::find(pc, buffer.cend(), '>');
-    std::string::const_iterator pnameend = std::find(pc, std::next(endpc), '=');
-    if (pnameend == std::next(endpc)) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-        }
-   // pc = pnameend;
-    std::string prefix;
-    if (*pc == ':') {
-        std::advance(pc, 1);
-        prefix.assign(pc, pnameend);
-        }
-    pc = std::next(pnameend);
-    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
-    if (pc == std::next(endpc)) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-        }
-    const char delim = *pc;
-    if (delim != '"' && delim != '\'') {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-        }
-    std::advance(pc, 1);
-    std::string::const_iterator pvalueend = std::find(pc, std::next(endpc), delim);
-    if (pvalueend == std::next(endpc)) {
-        std::cerr << "parser error : incomplete namespace\n";
-        exit(1);
-        }
-    const std::string uri(pc, pvalueend);
-    pc = std::next(pvalueend);
-    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
-    if (intag && *pc == '>') {
-        std::advance(pc, 1);
-        intag = false;
-        }
-    if (intag && *pc == '/' && *std::next(pc) == '>') {
-        std::advance(pc, 2);
-        intag = false;
-        }
+    if (commentHandler != nullptr)
+        commentHandler(std::string(comment));
 }
 
-// parse a XML attribute
-void XMLParser::parseAttribute() {
+// handle a XML characters before or after XML
+void XMLParser::handleCharactersBeforeOrAfter(std::string_view characters) {
 
-    if(handleAttributes != nullptr){
-        handleAttributes(local_name);
-    }
-    //std::string url;
-    endpc = std::find(pc, buffer.cend(), '>');
-    std::string::const_iterator pnameend = std::find(pc, std::next(endpc), '=');
-    if (pnameend == std::next(endpc))
-        exit(1);
-    const std::string qname(pc, pnameend);
-    const auto colonpos = qname.find(':');
-    std::string prefixbase;
-    if (colonpos != std::string::npos)
-        prefixbase = qname.substr(0, colonpos);
-    const std::string prefix = std::move(prefixbase);
-    std::string local_namebase;
-    if (colonpos != std::string::npos)
-        local_namebase = qname.substr(colonpos + 1);
-    else
-    local_namebase = qname;
-    const std::string local_name = std::move(local_namebase);
-    pc = std::next(pnameend);
-    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
-    if (pc == buffer.cend()) {
-        std::cerr << "parser error : attribute " << qname << " incomplete attribute\n";
-        exit(1);
-    }
-    char delim = *pc;
-    if (delim != '"' && delim != '\'') {
-        std::cerr << "parser error : attribute " << qname << " missing delimiter\n";
-        exit(1);
-    }
-    std::advance(pc, 1);
-    std::string::const_iterator pvalueend = std::find(pc, std::next(endpc), delim);
-    if (pvalueend == std::next(endpc)) {
-        std::cerr << "parser error : attribute " << qname << " missing delimiter\n";
-        exit(1);
-    }
-    const std::string value(pc, pvalueend);
-    if (local_name == "url")
-        url = value;
-    pc = std::next(pvalueend);
-    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
-    if (intag && *pc == '>') {
-        std::advance(pc, 1);
-        intag = false;
-    }
-    if (intag && *pc == '/' && *std::next(pc) == '>') {
-        std::advance(pc, 2);
-        intag = false;
-    }
+    if (charactersBeforeOrAfterHandler != nullptr)
+        charactersBeforeOrAfterHandler(std::string(characters));
 }
 
-// parse a XML CDATA
-void XMLParser::parseCDATA() {
-    
-    if(handleCDATA != nullptr){
-        handleCDATA(local_name);
-    }
-    const std::string endcdata = "]]>";
-    std::advance(pc, strlen("<![CDATA["));
-    endpc = std::search(pc, buffer.cend(), endcdata.begin(), endcdata.end());
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::search(pc, buffer.cend(), endcdata.begin(), endcdata.end());
-        if (endpc == buffer.cend())
-           exit(1);
-    }
-    const std::string characters(pc, endpc);
-    textsize += (int) characters.size();
-    loc += (int) std::count(characters.begin(), characters.end(), '\n');
-    pc = std::next(endpc, strlen("]]>"));
-}
+// handle a XML entity reference
+void XMLParser::handleEntityReference(std::string_view characters) {
 
-// parse a XML comment
-void XMLParser::parseComment() {
-    
-    if(handleComments != nullptr){
-        handleComments(local_name);
-    }
-    const std::string endcomment = "-->";
-    endpc = std::search(pc, buffer.cend(), endcomment.begin(), endcomment.end());
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::search(pc, buffer.cend(), endcomment.begin(), endcomment.end());
-        if (endpc == buffer.cend()) {
-            std::cerr << "parser error : Unterminated XML comment\n";
-            exit(1);
-        }
-    }
-    pc = std::next(endpc, strlen("-->"));
-    pc = std::find_if_not(pc, buffer.cend(), [] (char c) { return isspace(c); });
+    if (entityReferenceHandler != nullptr)
+        entityReferenceHandler(std::string(characters));
 }
 
-// parse a XML character before or after XML
-void XMLParser::parseCharactersBeforeOrAfter() {
-    
-    if(handleCharactersBeforeOrAfter != nullptr){
-        handleCharactersBeforeOrAfter(local_name);
-    }
-    pc = std::find_if_not(pc, buffer.cend(), [] (char c) { return isspace(c); });
-    if (pc == buffer.cend() || !isspace(*pc)) {
-        std::cerr << "parser error : Start tag expected, '<' not found\n";
-        exit(1);
-    }
-}
-
-// parse a XML entity references
-void XMLParser::parseEntityReference(std::string& characters) {
-    
-   // std::string characters;
-    if (std::distance(pc, buffer.cend()) < 3) {
-        pc = refillBuffer(pc, buffer, total);
-        if (std::distance(pc, buffer.cend()) < 3) {
-            std::cerr << "parser error : Incomplete entity reference, '" << std::string(pc, buffer.cend()) << "'\n";
-            exit(1);
-        }
-    }
-    if (*std::next(pc) == 'l' && *std::next(pc, 2) == 't' && *std::next(pc, 3) == ';') {
-        characters += '<';
-        std::advance(pc, strlen("&lt;"));
-    } else if (*std::next(pc) == 'g' && *std::next(pc, 2) == 't' && *std::next(pc, 3) == ';') {
-        characters += '>';
-        std::advance(pc, strlen("&gt;"));
-    } else if (*std::next(pc) == 'a' && *std::next(pc, 2) == 'm' && *std::next(pc, 3) == 'p') {
-        if (std::distance(pc, buffer.cend()) < 4) {
-            pc = refillBuffer(pc, buffer, total);
-            if (std::distance(pc, buffer.cend()) < 4) {
-                std::cerr << "parser error : Incomplete entity reference, '" << std::string(pc, buffer.cend()) << "'\n";
-                exit(1);
-            }
-        }
-        if (*std::next(pc, 4) != ';') {
-            const std::string partialEntity(pc, std::next(pc, 4));
-            std::cerr << "parser error : Incomplete entity reference, '" << partialEntity << "'\n";
-            exit(1);
-        }
-        characters += '&';
-        std::advance(pc, strlen("&amp;"));
-    } else {
-        characters += '&';
-        std::advance(pc, 1);
-    }
-    textsize += (int) characters.size();
-}
+// handle a XML characters
+void XMLParser::handleCharacters(std::string_view characters) {
 
-// parse a XML characters
-void XMLParser::parseCharacters() {
-    
-    if(handleCharacters != nullptr){
-        handleCharacters(local_name);
-    }
-    std::string::const_iterator endpc = std::find_if(pc, buffer.cend(), [] (char c) { return c == '<' || c == '&'; });
-    const std::string characters(pc, endpc);
-    loc += (int) std::count(characters.cbegin(), characters.cend(), '\n');
-    textsize += (int) characters.size();
-    pc = endpc;
+    if (charactersHandler != nullptr)
+        charactersHandler(std::string(characters));
 }
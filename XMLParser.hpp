@@ -1,19 +1,25 @@
 /*
     XMLParser.hpp
- 
-    Declaration file for XML parsing class
+
+    Declaration file for XML parsing class with std::function handlers
+
+    Adapter over XMLParserBase for callers that register handlers at
+    run time. Each handler is passed a copy of the event's main value
+    (e.g., the local name for tags), made only if the handler is set.
  */
 
 #ifndef INCLUDED_XMLPARSER_HPP
 #define INCLUDED_XMLPARSER_HPP
 
+#include "XMLParserBase.hpp"
 #include <string>
+#include <string_view>
 #include <functional>
 
-class XMLParser {
+class XMLParser : public XMLParserBase<XMLParser> {
 public:
-    
-    // constructor
+
+    // constructor, reading standard input
     XMLParser(std::function<void(const std::string&)>handleDeclarations,
               std::function<void(const std::string&)>handleRequiredVersion,
               std::function<void(const std::string&)>handleEncoding,
@@ -27,117 +33,76 @@ public:
               std::function<void(const std::string&)>handleCharactersBeforeOrAfter,
               std::function<void(const std::string&)>handleEntityReferences,
               std::function<void(const std::string&)>handleCharacters);
-    
-// parse the XML
-void parse();
-    
-// is done parsing
-bool isDone();
-    
-// is parsing at a XML declaration
-bool isXMLDeclaration();
-    
-// is parsing at a XML end tag
-bool isXMLEndTag();
-    
-// is parsing at a XML start tag
-bool isXMLStartTag();
-    
-// is parsing at a XML Namespace
-bool isXMLNamespace();
-    
-// is parsing at a XML attribute
-bool isXMLAttribute();
-    
-// is parsing at a XML CDATA
-bool isXMLCDATA();
-    
-// is parsing at a XML comment
-bool isXMLComment();
-
-// is parsing at characters before or after XML
-bool isCharactersBeforeOrAfter();
-
-// is parsing at a XML entity characters
-bool isXMLEntityCharacters();
-
-// is parsing at a XML characters
-bool isXMLCharacters();
-
-// parse declaration
-void parseDeclaration(std::string& name);
-
-// parse required version
-void parseRequiredVersion();
-
-// parse a XML encoding
-void parseEncoding();
-
-// parse a XML standalone
-void parseStandalone();
-
-// parse a XML end tag
-void parseEndTag();
-
-// parse a XML start tag
-void parseStartTag();
-
-// parse a XML namespace
-void parseNameSpace();
-
-// parse a XML attribute
-void parseAttribute();
-
-// parse a XML CDATA
-void parseCDATA();
-
-// parse a XML comment
-void parseComment();
-    
-// parse a XML character before or after XML
-void parseCharactersBeforeOrAfter();
- 
-// parse a XML entity references
-void parseEntityReference(std::string& characters);
-    
-// parse a XML characters
-void parseCharacters();
-    
+
+    // constructor, reading a source, e.g., a file path
+    XMLParser(InputSource source,
+              std::function<void(const std::string&)>handleDeclarations,
+              std::function<void(const std::string&)>handleRequiredVersion,
+              std::function<void(const std::string&)>handleEncoding,
+              std::function<void(const std::string&)>handleStandalones,
+              std::function<void(const std::string&)>handleEndTags,
+              std::function<void(const std::string&)>handleStartTags,
+              std::function<void(const std::string&)>handleNameSpaces,
+              std::function<void(const std::string&)>handleAttributes,
+              std::function<void(const std::string&)>handleCDATA,
+              std::function<void(const std::string&)>handleComments,
+              std::function<void(const std::string&)>handleCharactersBeforeOrAfter,
+              std::function<void(const std::string&)>handleEntityReferences,
+              std::function<void(const std::string&)>handleCharacters);
+
+// handle a XML declaration
+void handleDeclaration(std::string_view target);
+
+// handle a XML required version
+void handleRequiredVersion(std::string_view version);
+
+// handle a XML encoding
+void handleEncoding(std::string_view encoding);
+
+// handle a XML standalone
+void handleStandalone(std::string_view standalone);
+
+// handle a XML end tag
+void handleEndTag(std::string_view qname, std::string_view prefix, std::string_view local_name, ElementID id, NamespaceID ns);
+
+// handle a XML start tag
+void handleStartTag(std::string_view qname, std::string_view prefix, std::string_view local_name, ElementID id, NamespaceID ns);
+
+// handle a XML namespace
+void handleNameSpace(std::string_view prefix, std::string_view uri);
+
+// handle a XML attribute
+void handleAttribute(std::string_view qname, std::string_view prefix, std::string_view local_name, std::string_view value, NamespaceID ns);
+
+// handle a XML CDATA
+void handleCDATA(std::string_view characters);
+
+// handle a XML comment
+void handleComment(std::string_view comment);
+
+// handle a XML characters before or after XML
+void handleCharactersBeforeOrAfter(std::string_view characters);
+
+// handle a XML entity reference
+void handleEntityReference(std::string_view characters);
+
+// handle a XML characters
+void handleCharacters(std::string_view characters);
+
 private:
-    std::function<void(const std::string&)>handleDeclarations;
-    std::function<void(const std::string&)>handleRequiredVersion;
-    std::function<void(const std::string&)>handleEncoding;
-    std::function<void(const std::string&)>handleStandalones;
-    std::function<void(const std::string&)>handleEndTags;
-    std::function<void(const std::string&)>handleStartTags;
-    std::function<void(const std::string&)>handleNameSpaces;
-    std::function<void(const std::string&)>handleAttributes;
-    std::function<void(const std::string&)>handleCDATA;
-    std::function<void(const std::string&)>handleComments;
-    std::function<void(const std::string&)>handleCharactersBeforeOrAfter;
-    std::function<void(const std::string&)>handleEntityReferences;
-    std::function<void(const std::string&)>handleCharacters;
-    
-    std::string local_name;
-    std::string::const_iterator pc;
-    std::string::const_iterator endpc;
-    std::string buffer;
-    long total = 0;
-    bool intag = false;
-    int depth = 0;
-    int textsize = 0;
-    int loc = 0;
-    std::string url;
-    
-    int expr_count = 0;
-    int function_count = 0;
-    int class_count = 0;
-    int file_count = 0;
-    int decl_count = 0;
-    int comment_count = 0;
-    int stringLiteral_count = 0;
-    int blockComment_count = 0;
-    int return_count = 0;
+    std::function<void(const std::string&)> declarationHandler;
+    std::function<void(const std::string&)> requiredVersionHandler;
+    std::function<void(const std::string&)> encodingHandler;
+    std::function<void(const std::string&)> standaloneHandler;
+    std::function<void(const std::string&)> endTagHandler;
+    std::function<void(const std::string&)> startTagHandler;
+    std::function<void(const std::string&)> nameSpaceHandler;
+    std::function<void(const std::string&)> attributeHandler;
+    std::function<void(const std::string&)> CDATAHandler;
+    std::function<void(const std::string&)> commentHandler;
+    std::function<void(const std::string&)> charactersBeforeOrAfterHandler;
+    std::function<void(const std::string&)> entityReferenceHandler;
+    std::function<void(const std::string&)> charactersHandler;
 };
 
 #endif
@@ -0,0 +1,1506 @@
+/*
+    XMLParserBase.hpp
+
+    Declaration and implementation of the XML parsing class template,
+    a CRTP base whose derived class provides the handlers
+ */
+
+#ifndef INCLUDED_XMLPARSERBASE_HPP
+#define INCLUDED_XMLPARSERBASE_HPP
+
+#include "InputSource.hpp"
+#include "refillBuffer.hpp"
+#include "mapInput.hpp"
+#include "scanDelimiters.hpp"
+#include "AsyncReader.hpp"
+#include "ElementNames.hpp"
+#include "NamespaceNames.hpp"
+#include "Decompressor.hpp"
+#include "Checkpoint.hpp"
+#include "ParseProfile.hpp"
+#include "Arena.hpp"
+#include "decodeEntities.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// parseNext() is too large for compilers to inline on their own, and
+// parse() calls it once per part
+#if defined(_MSC_VER)
+#define XMLPARSER_ALWAYS_INLINE __forceinline
+#else
+#define XMLPARSER_ALWAYS_INLINE __attribute__((always_inline)) inline
+#endif
+
+/*
+    XML parser, a CRTP base. A derived class provides the handlers as
+    member functions with the same names and signatures as the
+    defaults below, e.g.,
+
+        class Counter : public XMLParserBase<Counter> {
+        public:
+            void handleStartTag(std::string_view qname, std::string_view prefix, std::string_view local_name, ElementID id, NamespaceID ns);
+        };
+
+    Handlers are resolved at compile time, so they inline into the
+    parser, and events without one call an empty default. Names,
+    values, and text are views into the input buffer, valid only for
+    the handler call. A parser has no global state, so parsers can run
+    at the same time, e.g., one per thread.
+*/
+template <class Derived>
+class XMLParserBase {
+public:
+
+    // constructor, reading standard input
+    explicit XMLParserBase(bool asyncRead = false);
+
+    // constructor, reading a source, e.g., a file path
+    explicit XMLParserBase(InputSource source, bool asyncRead = false);
+
+    // constructor over input already in memory
+    XMLParserBase(const char* begin, const char* end, int depth = 0);
+
+    // constructor, resuming standard input positioned at the checkpoint offset
+    XMLParserBase(const Checkpoint& checkpoint, bool asyncRead = false);
+
+    // destructor
+    ~XMLParserBase();
+
+    XMLParserBase(const XMLParserBase&) = delete;
+    XMLParserBase& operator=(const XMLParserBase&) = delete;
+
+// parse the XML
+void parse();
+
+// start over with another source, reusing the buffer, element names, and arena
+void reset(InputSource source, bool asyncRead = false);
+
+// parse the next part of the XML, e.g., one tag or attribute, or chunk of a large CDATA or comment, returning false at the end of input
+bool parseNext();
+
+// skip the rest of an open element, through its end tag, without calling handlers
+void skipElement(int elementDepth);
+
+// is done parsing
+bool isDone();
+
+// offset in the input of the current position
+long offset() const;
+
+// total bytes of input
+long totalBytes() const;
+
+// element names of the IDs passed to the tag handlers
+const ElementNames& elementNames() const;
+
+// namespaces of the IDs passed to the tag and attribute handlers
+const NamespaceNames& namespaceNames() const;
+
+// start with the namespace declarations of another parser, e.g., of the root element for a part of a document
+void inheritNamespaces(const NamespaceNames& other);
+
+// offset in the input of the tag being handled
+long tagOffset() const;
+
+// text of the tag being handled, from '<' to '>'
+std::string_view tagText() const;
+
+// parser state at the start of the tag being handled
+Checkpoint tagCheckpoint() const;
+
+// copy of a value in the arena, valid until the end of the unit
+std::string_view keep(std::string_view value);
+
+// is parsing at a XML declaration
+bool isXMLDeclaration();
+
+// is parsing at a XML end tag
+bool isXMLEndTag();
+
+// is parsing at a XML start tag
+bool isXMLStartTag();
+
+// is parsing at a XML Namespace
+bool isXMLNamespace();
+
+// is parsing at a XML attribute
+bool isXMLAttribute();
+
+// is parsing at a XML CDATA
+bool isXMLCDATA();
+
+// is parsing at a XML comment
+bool isXMLComment();
+
+// is parsing at characters before or after XML
+bool isCharactersBeforeOrAfter();
+
+// is parsing at a XML entity characters
+bool isXMLEntityCharacters();
+
+// is parsing at a XML characters
+bool isXMLCharacters();
+
+// parse declaration
+void parseDeclaration();
+
+// parse required version
+void parseRequiredVersion();
+
+// parse a XML encoding
+void parseEncoding();
+
+// parse a XML standalone
+void parseStandalone();
+
+// parse a XML end tag
+void parseEndTag();
+
+// parse a XML start tag
+void parseStartTag();
+
+// parse a XML namespace
+void parseNameSpace();
+
+// parse a XML attribute
+void parseAttribute();
+
+// parse a XML CDATA
+void parseCDATA();
+
+// parse the next chunk of a XML CDATA
+void parseCDATAChunk();
+
+// parse a XML comment
+void parseComment();
+
+// parse the next chunk of a XML comment
+void parseCommentChunk();
+
+// parse a XML character before or after XML
+void parseCharactersBeforeOrAfter();
+
+// parse a XML entity references
+void parseEntityReference();
+
+// parse a XML characters
+void parseCharacters();
+
+// default handlers, hidden by the handlers of the derived class
+void handleDeclaration(std::string_view /* target */) {}
+void handleRequiredVersion(std::string_view /* version */) {}
+void handleEncoding(std::string_view /* encoding */) {}
+void handleStandalone(std::string_view /* standalone */) {}
+void handleEndTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID /* id */, NamespaceID /* ns */) {}
+void handleStartTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID /* id */, NamespaceID /* ns */) {}
+void handleNameSpace(std::string_view /* prefix */, std::string_view /* uri */) {}
+void handleAttribute(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, std::string_view /* value */, NamespaceID /* ns */) {}
+void handleCDATA(std::string_view /* characters */) {}
+void handleComment(std::string_view /* comment */) {}
+void handleCharactersBeforeOrAfter(std::string_view /* characters */) {}
+void handleEntityReference(std::string_view /* characters */) {}
+void handleCharacters(std::string_view /* characters */) {}
+void handleText(std::string_view /* text */) {}
+void handleInput(std::string_view /* input */) {}
+
+// default chunk handlers, passing each chunk on as if it were whole
+void handleCDATAChunk(std::string_view characters, int /* flags */) { derived().handleCDATA(characters); }
+void handleCommentChunk(std::string_view comment, int /* flags */) { derived().handleComment(comment); }
+
+// flags of a chunk of a CDATA section or comment, a whole one has both
+enum ChunkFlags {
+    CHUNK_CONTINUE = 0,
+    CHUNK_BEGIN = 1,
+    CHUNK_END = 2,
+    CHUNK_WHOLE = CHUNK_BEGIN | CHUNK_END
+};
+
+// derived class has a handler for attributes or namespaces, so start tags are parsed attribute by attribute
+static constexpr bool handlesAttributes();
+
+// derived class has a handler for characters or entity references, so text is decoded
+static constexpr bool handlesCharacters();
+
+// derived class has a handler for end tags, so their names are parsed
+static constexpr bool handlesEndTags();
+
+// derived class has a handler for the raw input, so complete input is passed on in parts
+static constexpr bool handlesInput();
+
+protected:
+    // the derived class with the handlers
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    // start reading a source, mapping or reading its first block
+    void open(InputSource source, bool asyncRead);
+
+    // refill the buffer, adjusting the current position
+    void refill();
+
+    // replace the input with the output of the decompressor, on a reader thread
+    void decompress(std::shared_ptr<Decompressor> decompressor);
+
+    // search for a delimiter from pc, refilling as needed
+    const char* skipSearch(std::size_t from, std::string_view delimiter);
+
+    // a handler of the derived class hides the default, so its member pointer is of the derived class
+    template <class... Args>
+    static constexpr bool isDerivedHandler(void (Derived::*)(Args...)) { return true; }
+    template <class... Args>
+    static constexpr bool isDerivedHandler(void (XMLParserBase::*)(Args...)) { return false; }
+
+    static constexpr int XMLNS_SIZE = 5;
+
+    const char* pc = nullptr;
+    const char* endpc = nullptr;
+    const char* bufferEnd = nullptr;
+    // start of the input not yet passed to handleInput()
+    const char* inputMark = nullptr;
+    InputSource input = InputSource::fromMemory(nullptr, nullptr);
+    std::string buffer;
+    const char* mapBegin = nullptr;
+    const char* mapEnd = nullptr;
+    bool mapped = false;
+    bool inputComplete = false;
+    std::unique_ptr<AsyncReader> reader;
+    long total = 0;
+    bool intag = false;
+    int depth = 0;
+    ElementNames names;
+    NamespaceNames namespaces;
+    // offset in the input file of the start of the input
+    long startOffset = 0;
+    // start of the tag being handled, and the depth before it
+    const char* tagStart = nullptr;
+    int tagDepth = 0;
+    // values kept by handlers, reset at the end of each unit
+    Arena arena;
+    // characters of the entity reference being handled
+    char entityCharacters[ENTITY_MAX_CHARACTERS];
+    // a CDATA section or comment larger than the buffer, with its chunks passed so far
+    bool inCDATA = false;
+    bool inComment = false;
+    int chunkFlags = CHUNK_BEGIN;
+    // parts, bytes, and sampled cycles of each stage, compiled out without SRCFACTS_PROFILE
+#if defined(SRCFACTS_PROFILE)
+    ParseProfile profile;
+#endif
+};
+
+// constructor, reading standard input
+template <class Derived>
+XMLParserBase<Derived>::XMLParserBase(bool asyncRead)
+    : XMLParserBase(InputSource::fromFD(0), asyncRead)
+{}
+
+/*
+    Constructor, reading a source (see InputSource.hpp): a file
+    descriptor, a file path, memory, or a callback.
+
+    @param source Source of the input
+    @param asyncRead Read on a separate thread when input is not mapped
+*/
+template <class Derived>
+XMLParserBase<Derived>::XMLParserBase(InputSource source, bool asyncRead) {
+
+    open(std::move(source), asyncRead);
+}
+
+// constructor over input already in memory, e.g., a unit at a depth in a document
+template <class Derived>
+XMLParserBase<Derived>::XMLParserBase(const char* begin, const char* end, int depth)
+    : XMLParserBase(InputSource::fromMemory(begin, end))
+{
+    this->depth = depth;
+}
+
+/*
+    Constructor, resuming a parse of standard input. Input must be
+    positioned at the offset of the checkpoint, e.g., by
+    Checkpoint::seekInput(), and the parse continues with its state.
+
+    @param checkpoint Checkpoint to resume from
+    @param asyncRead Read on a separate thread when input is not mapped
+*/
+template <class Derived>
+XMLParserBase<Derived>::XMLParserBase(const Checkpoint& checkpoint, bool asyncRead)
+    : XMLParserBase(asyncRead)
+{
+    if (startOffset != checkpoint.offset) {
+        std::cerr << "parser error : Input is not at the checkpoint offset\n";
+        exit(1);
+    }
+    depth = checkpoint.depth;
+    intag = checkpoint.intag;
+
+    // the declarations of the open elements, restored in the scope of the outermost one
+    for (const auto& ns : checkpoint.namespaces)
+        namespaces.declare(ns.first, ns.second, 1);
+}
+
+// destructor
+template <class Derived>
+XMLParserBase<Derived>::~XMLParserBase() {
+
+    // stop the reader thread before its input goes away
+    reader.reset();
+    if (mapped)
+        unmapInput(mapBegin, mapEnd);
+#if defined(SRCFACTS_PROFILE)
+    ParseProfile::mergeTotal(profile);
+#endif
+}
+
+/*
+    Start reading a source. A file descriptor of a regular file, e.g.,
+    standard input redirected from a file, is mapped and walked in
+    place, as is input in memory. Otherwise input is read through the
+    buffer, or with asyncRead, by a reader thread so reading overlaps
+    parsing.
+
+    Compressed input (gzip, zip, zstd) is detected from its first bytes
+    and always decompressed by a reader thread, straight into the
+    blocks the parser walks. Mapped or memory compressed input is
+    decompressed in place. Input from a callback is not decompressed.
+
+    @param source Source of the input
+    @param asyncRead Read on a separate thread when input is not mapped
+*/
+template <class Derived>
+void XMLParserBase<Derived>::open(InputSource source, bool asyncRead) {
+
+    input = std::move(source);
+    if (!input.isOpen()) {
+        std::cerr << "parser error : Cannot open input\n";
+        exit(1);
+    }
+    if (input.kind() == InputSource::MEMORY) {
+        pc = input.begin();
+        bufferEnd = input.end();
+    } else if (input.kind() == InputSource::FD) {
+        startOffset = inputOffset(input.fd());
+        mapped = mapInput(input.fd(), pc, bufferEnd);
+    }
+    inputMark = pc;
+    if (mapped || input.kind() == InputSource::MEMORY) {
+        mapBegin = pc;
+        mapEnd = bufferEnd;
+        if (Decompressor::format(mapBegin, mapEnd) == Decompressor::NONE) {
+            inputComplete = true;
+            total = (long) std::distance(pc, bufferEnd);
+            return;
+        }
+        decompress(std::make_shared<Decompressor>(mapBegin, mapEnd));
+        return;
+    }
+
+    // first block, read here to check for compressed input
+    pc = buffer.data();
+    bufferEnd = pc;
+    inputMark = pc;
+    refill();
+    if (input.kind() == InputSource::FD && Decompressor::format(pc, bufferEnd) != Decompressor::NONE) {
+        decompress(std::make_shared<Decompressor>(input.fd(), pc, bufferEnd));
+    } else if (asyncRead) {
+        // the reader thread continues after the first block
+        reader.reset(new AsyncReader([source = &input](char* data, long size) { return source->read(data, size); }));
+    }
+}
+
+/*
+    Start over with another source, e.g., the next of many documents,
+    without constructing a parser. The buffer, the element names, and
+    the chunks of the arena are reused. The reader thread and mapping
+    of the last source are closed first, and the rest of its input is
+    not parsed. The derived class resets its own state, e.g., counts.
+
+    With asyncRead, a read of the last source in progress is not
+    interrupted, so before the end of a pipe, reset() waits until its
+    writer sends more data or closes it. Reset a parser of a source
+    that can block only after its parse is done.
+
+    @param source Source of the input
+    @param asyncRead Read on a separate thread when input is not mapped
+*/
+template <class Derived>
+void XMLParserBase<Derived>::reset(InputSource source, bool asyncRead) {
+
+    reader.reset();
+    if (mapped)
+        unmapInput(mapBegin, mapEnd);
+    pc = nullptr;
+    endpc = nullptr;
+    bufferEnd = nullptr;
+    inputMark = nullptr;
+    // the capacity is kept
+    buffer.clear();
+    mapBegin = nullptr;
+    mapEnd = nullptr;
+    mapped = false;
+    inputComplete = false;
+    total = 0;
+    intag = false;
+    depth = 0;
+    inCDATA = false;
+    inComment = false;
+    namespaces.reset();
+    startOffset = 0;
+    tagStart = nullptr;
+    tagDepth = 0;
+    arena.reset();
+
+    open(std::move(source), asyncRead);
+}
+
+/*
+    Replace the input with the output of the decompressor, run by a
+    reader thread. Any input already counted was compressed, so the
+    total restarts with the decompressed bytes.
+
+    @param decompressor Decompressor of the input
+*/
+template <class Derived>
+void XMLParserBase<Derived>::decompress(std::shared_ptr<Decompressor> decompressor) {
+
+    reader.reset(new AsyncReader([decompressor](char* data, long size) { return decompressor->read(data, size); }));
+    total = 0;
+    pc = nullptr;
+    bufferEnd = nullptr;
+    inputMark = nullptr;
+    refill();
+}
+
+// refill the buffer, adjusting the current position
+template <class Derived>
+void XMLParserBase<Derived>::refill() {
+
+    // mapped or in-memory input is already complete
+    if (inputComplete)
+        return;
+
+    // the input before pc is done with, and may be overwritten
+    PROFILE_HANDLER(derived().handleInput(std::string_view(inputMark, std::distance(inputMark, pc))));
+
+#if defined(SRCFACTS_PROFILE)
+    const std::uint64_t refillStart = ParseProfile::now();
+    const long refillTotal = total;
+#endif
+    if (reader) {
+        // blocks from the reader thread, and at the end of input, the unprocessed characters stay in place
+        if (!reader->refill(pc, bufferEnd, total))
+            inputComplete = true;
+    } else {
+        const auto leftover = std::distance(pc, bufferEnd);
+        auto it = refillBuffer(std::next(buffer.cbegin(), std::distance((const char*) buffer.data(), pc)), buffer, total, input);
+        if (it == buffer.cend()) {
+            // at the end of input, the unprocessed characters were moved to the start of the buffer
+            inputComplete = true;
+            pc = buffer.data();
+            bufferEnd = pc + leftover;
+        } else {
+            pc = buffer.data() + std::distance(buffer.cbegin(), it);
+            bufferEnd = buffer.data() + buffer.size();
+        }
+    }
+    inputMark = pc;
+#if defined(SRCFACTS_PROFILE)
+    profile.addRefill(ParseProfile::now() - refillStart, total - refillTotal);
+#endif
+}
+
+/*
+    Parse the XML, calling parseNext() until the end of input.
+
+    handleInput() receives the raw input, in order, each byte exactly
+    once: the consumed part of the buffer just before each refill, and
+    the rest at the end. Complete input, e.g., mapped, has no refills,
+    so it is passed on here as the parse goes, in parts of about
+    BUFFER_SIZE bytes. The input is unchanged until the handler
+    returns, so it can be forwarded without copying.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parse() {
+
+    while (parseNext()) {
+
+        // complete input has no refills, so pass on the raw input as if the buffer were refilled
+        if constexpr (handlesInput()) {
+            if (inputComplete && std::distance(inputMark, pc) >= BUFFER_SIZE) {
+                PROFILE_HANDLER(derived().handleInput(std::string_view(inputMark, std::distance(inputMark, pc))));
+                inputMark = pc;
+            }
+        }
+    }
+}
+
+/*
+    Parse the next part of the XML, calling its handlers. A part is a
+    declaration, tag, namespace, attribute, CDATA, comment, entity
+    reference, or characters. A CDATA section or comment larger than
+    the buffer is parsed one chunk per call, so each chunk is handled
+    before the refill that overwrites it, and a caller of parseNext(),
+    e.g., XMLCursor, sees one chunk at a time.
+
+    @return false at the end of input
+*/
+template <class Derived>
+XMLPARSER_ALWAYS_INLINE bool XMLParserBase<Derived>::parseNext() {
+
+    // the next chunk of a CDATA section or comment, after what is left of the last one
+    if (inCDATA || inComment) {
+#if defined(SRCFACTS_PROFILE)
+        const std::uint64_t chunkStart = profile.startPart() ? ParseProfile::now() : 0;
+        const ProfileStage chunkStage = inCDATA ? STAGE_CDATA : STAGE_COMMENT;
+#endif
+        refill();
+#if defined(SRCFACTS_PROFILE)
+        const long chunkOffset = offset();
+#endif
+        if (inCDATA)
+            parseCDATAChunk();
+        else
+            parseCommentChunk();
+#if defined(SRCFACTS_PROFILE)
+        profile.endPart(chunkStage, offset() - chunkOffset, chunkStart);
+#endif
+        return true;
+    }
+
+    while (std::distance(pc, bufferEnd) < 5) {
+        // refill buffer and adjust iterator
+        refill();
+        if (isDone()) {
+            // the rest of the input
+            PROFILE_HANDLER(derived().handleInput(std::string_view(inputMark, std::distance(inputMark, pc))));
+            inputMark = pc;
+            return false;
+        }
+        // complete input has no more data, so parse the short tail in place
+        if (inputComplete)
+            break;
+    }
+#if defined(SRCFACTS_PROFILE)
+    // refills before the part are their own stage
+    const std::uint64_t partStart = profile.startPart() ? ParseProfile::now() : 0;
+    const long partOffset = offset();
+    ProfileStage stage = STAGE_CHARACTERS;
+#endif
+    if (isXMLDeclaration()) {
+        PROFILE_STAGE(STAGE_DECLARATION);
+        // parse XML declaration
+        parseDeclaration();
+        // parse required version
+        parseRequiredVersion();
+        //parse encoding
+        parseEncoding();
+        //parse standalone
+        parseStandalone();
+    } else if (isXMLEndTag()) {
+        PROFILE_STAGE(STAGE_END_TAG);
+        // parse end tag
+        parseEndTag();
+    } else if (isXMLCDATA()) {
+        PROFILE_STAGE(STAGE_CDATA);
+        // parse CDATA, before start tags since both begin with '<'
+        parseCDATA();
+    } else if (isXMLComment()) {
+        PROFILE_STAGE(STAGE_COMMENT);
+        // parse XML comment
+        parseComment();
+    } else if (isXMLStartTag()) {
+        PROFILE_STAGE(STAGE_START_TAG);
+        // parse start tag
+        parseStartTag();
+    } else if (isXMLNamespace()) {
+        PROFILE_STAGE(STAGE_NAMESPACE);
+        // parse namespace
+        parseNameSpace();
+    } else if (isXMLAttribute()) {
+        PROFILE_STAGE(STAGE_ATTRIBUTE);
+        // parse attribute
+        parseAttribute();
+    } else if (isCharactersBeforeOrAfter()) {
+        PROFILE_STAGE(STAGE_CHARACTERS_BEFORE_OR_AFTER);
+        // parse characters before or after XML
+        parseCharactersBeforeOrAfter();
+    } else if (isXMLEntityCharacters()) {
+        PROFILE_STAGE(STAGE_ENTITY_REFERENCE);
+        // parse entity references
+        parseEntityReference();
+    } else if (isXMLCharacters()) {
+        PROFILE_STAGE(STAGE_CHARACTERS);
+        // parse characters
+        parseCharacters();
+    }
+#if defined(SRCFACTS_PROFILE)
+    profile.endPart(stage, offset() - partOffset, partStart);
+#endif
+
+    return true;
+}
+
+/*
+    Skip the rest of an open element, through its end tag, without
+    calling handlers. Only the markup delimiters are scanned, and
+    depth is tracked from start and end tags, so attributes, text,
+    and entity references inside are not parsed. Comments, CDATA, and
+    processing instructions are skipped whole, since they may contain
+    '<'. The skipped input is still passed to handleInput(). Called
+    between parts, e.g., from a tag handler or by a caller of
+    parseNext() such as XMLCursor.
+
+    @param elementDepth Depth before the start tag of the element, i.e., the depth after its end tag
+*/
+template <class Derived>
+void XMLParserBase<Derived>::skipElement(int elementDepth) {
+
+    // already ended
+    if (depth <= elementDepth)
+        return;
+
+    // rest of a CDATA section or comment passed in chunks so far
+    if (inCDATA)
+        pc = std::next(skipSearch(0, "]]>"), 3);
+    else if (inComment)
+        pc = std::next(skipSearch(0, "-->"), 3);
+    inCDATA = false;
+    inComment = false;
+
+    // rest of the start tag, which may be an empty element
+    if (intag) {
+        const char* ptagend = skipSearch(0, ">");
+        intag = false;
+        if (ptagend != pc && *std::prev(ptagend) == '/')
+            --depth;
+        pc = std::next(ptagend);
+    }
+
+    while (depth > elementDepth) {
+
+        // skip characters to the next markup, keeping none of them
+        const char* pmarkup = scanChar(pc, bufferEnd, '<');
+        while (pmarkup == bufferEnd) {
+            pc = bufferEnd;
+            refill();
+            if (isDone()) {
+                std::cerr << "parser error : Incomplete element, end of input in skipped element\n";
+                exit(1);
+            }
+            pmarkup = scanChar(pc, bufferEnd, '<');
+        }
+        pc = pmarkup;
+
+        // enough characters to tell the kind of markup
+        while (std::distance(pc, bufferEnd) < 9 && !inputComplete)
+            refill();
+        const std::string_view markup(pc, std::distance(pc, bufferEnd));
+        if (markup.substr(0, 2) == "</") {
+            pc = std::next(skipSearch(2, ">"));
+            --depth;
+        } else if (markup.substr(0, 4) == "<!--") {
+            pc = std::next(skipSearch(4, "-->"), 3);
+        } else if (markup.substr(0, 9) == "<![CDATA[") {
+            pc = std::next(skipSearch(9, "]]>"), 3);
+        } else if (markup.substr(0, 2) == "<?") {
+            pc = std::next(skipSearch(2, "?>"), 2);
+        } else if (markup.substr(0, 2) == "<!") {
+            pc = std::next(skipSearch(2, ">"));
+        } else {
+            const char* ptagend = skipSearch(1, ">");
+            if (*std::prev(ptagend) != '/')
+                ++depth;
+            pc = std::next(ptagend);
+        }
+    }
+}
+
+/*
+    Search for a delimiter in the buffer from pc, refilling as needed.
+    Before a refill, the characters searched are dropped, except the
+    last few, so the skipped markup can be larger than the buffer. The
+    character before the delimiter is always kept, e.g., the '/' of an
+    empty element.
+
+    @param from Offset from pc to start the search at
+    @param delimiter Characters to search for
+    @return Pointer to the start of the delimiter
+*/
+template <class Derived>
+const char* XMLParserBase<Derived>::skipSearch(std::size_t from, std::string_view delimiter) {
+
+    while (true) {
+        const char* start = std::next(pc, std::min<std::ptrdiff_t>((std::ptrdiff_t) from, std::distance(pc, bufferEnd)));
+        const char* found = delimiter.size() == 1 ? scanChar(start, bufferEnd, delimiter[0])
+                                                  : std::search(start, bufferEnd, delimiter.begin(), delimiter.end());
+        if (found != bufferEnd)
+            return found;
+        if (inputComplete) {
+            std::cerr << "parser error : Incomplete markup, end of input in skipped element\n";
+            exit(1);
+        }
+
+        // a delimiter may start in the characters already searched
+        const std::size_t searched = (std::size_t) std::distance(pc, bufferEnd);
+        if (searched > from + delimiter.size()) {
+            pc = std::prev(bufferEnd, delimiter.size());
+            from = 1;
+        } else {
+            from = std::max(from, searched >= delimiter.size() ? searched - (delimiter.size() - 1) : 0);
+        }
+        refill();
+    }
+}
+
+/*
+    Derived class has a handler for attributes or namespaces. Parts
+    without a handler are not parsed at all, in a structural mode for
+    jobs that only count elements: this one, handlesCharacters(), and
+    handlesEndTags() select it. Depth is kept in every mode.
+
+    @return false if the rest of a start tag can be passed over in one step
+*/
+template <class Derived>
+constexpr bool XMLParserBase<Derived>::handlesAttributes() {
+
+    return isDerivedHandler(&Derived::handleAttribute) || isDerivedHandler(&Derived::handleNameSpace);
+}
+
+/*
+    Derived class has a handler for characters or entity references.
+    Without one, the text up to the next markup is passed whole, with
+    entity references not decoded, to handleText().
+
+    @return false if text can be passed whole to handleText()
+*/
+template <class Derived>
+constexpr bool XMLParserBase<Derived>::handlesCharacters() {
+
+    return isDerivedHandler(&Derived::handleCharacters) || isDerivedHandler(&Derived::handleEntityReference);
+}
+
+/*
+    Derived class has a handler for end tags.
+
+    @return false if an end tag can be passed over in one step
+*/
+template <class Derived>
+constexpr bool XMLParserBase<Derived>::handlesEndTags() {
+
+    return isDerivedHandler(&Derived::handleEndTag);
+}
+
+/*
+    Derived class has a handler for the raw input.
+
+    @return false if complete input need not be passed on until the end
+*/
+template <class Derived>
+constexpr bool XMLParserBase<Derived>::handlesInput() {
+
+    return isDerivedHandler(&Derived::handleInput);
+}
+
+// is done parsing
+template <class Derived>
+bool XMLParserBase<Derived>::isDone() {
+
+    return pc == bufferEnd;
+}
+
+// offset in the input of the current position
+template <class Derived>
+long XMLParserBase<Derived>::offset() const {
+
+    return startOffset + total - (long) std::distance(pc, bufferEnd);
+}
+
+// total bytes of input
+template <class Derived>
+long XMLParserBase<Derived>::totalBytes() const {
+
+    return total;
+}
+
+// element names of the IDs passed to the tag handlers
+template <class Derived>
+const ElementNames& XMLParserBase<Derived>::elementNames() const {
+
+    return names;
+}
+
+/*
+    Offset in the input of the tag being handled. For compressed input,
+    the offset is in the decompressed input.
+
+    @return Offset of the '<' of the tag
+*/
+template <class Derived>
+long XMLParserBase<Derived>::tagOffset() const {
+
+    return startOffset + total - (long) std::distance(tagStart, bufferEnd);
+}
+
+// text of the tag being handled, from '<' to '>'
+template <class Derived>
+std::string_view XMLParserBase<Derived>::tagText() const {
+
+    return std::string_view(tagStart, std::distance(tagStart, endpc) + 1);
+}
+
+/*
+    Parser state at the start of the tag being handled, for resuming
+    the parse with this tag. Only the parser state is set, the derived
+    class adds its open elements and counts, and saves it (see
+    Checkpoint.hpp). A later parse of the same, or an extended, input
+    seeks to the offset and resumes there.
+
+    @return Checkpoint with the offset, depth, and intag
+*/
+template <class Derived>
+Checkpoint XMLParserBase<Derived>::tagCheckpoint() const {
+
+    Checkpoint checkpoint;
+    checkpoint.offset = tagOffset();
+    checkpoint.depth = tagDepth;
+    checkpoint.intag = false;
+    checkpoint.namespaces = namespaces.scope(tagDepth);
+
+    return checkpoint;
+}
+
+/*
+    Copy of a value in the arena, e.g., an attribute value needed at
+    the end tag. Views passed to handlers are into the input buffer,
+    and only valid during the call. The arena (see Arena.hpp) is reset
+    at the end tag of each unit, so the memory of kept values is the
+    most of any one unit, however large the input. A unit skipped with
+    skipElement() does not reset it.
+
+    @param value Characters to keep
+    @return View of the copy, valid until the end tag handler of the next unit element returns
+*/
+template <class Derived>
+std::string_view XMLParserBase<Derived>::keep(std::string_view value) {
+
+    return arena.copy(value);
+}
+
+// namespaces of the IDs passed to the tag and attribute handlers
+template <class Derived>
+const NamespaceNames& XMLParserBase<Derived>::namespaceNames() const {
+
+    return namespaces;
+}
+
+/*
+    Start with the namespace declarations of another parser. A parser
+    of a part of a document, e.g., a unit of an archive, has the
+    declarations of the root element in scope.
+
+    @param other Namespaces of the other parser
+*/
+template <class Derived>
+void XMLParserBase<Derived>::inheritNamespaces(const NamespaceNames& other) {
+
+    namespaces = other;
+}
+
+// is parsing at a XML declaration
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLDeclaration() {
+
+    return *pc == '<' && *std::next(pc) == '?';
+}
+
+// is parsing at a XML end tag
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLEndTag() {
+
+    return *pc == '<' && *std::next(pc) == '/';
+}
+
+// is parsing at a XML start tag
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLStartTag() {
+
+    return *pc == '<' && *std::next(pc) != '/' && *std::next(pc) != '?';
+}
+
+// is parsing at a XML namespace
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLNamespace() {
+
+    return intag && *pc != '>' && *pc != '/' && std::distance(pc, bufferEnd) > (int) XMLNS_SIZE && std::memcmp(pc, "xmlns", XMLNS_SIZE) == 0
+    && (*std::next(pc, XMLNS_SIZE) == ':' || *std::next(pc, XMLNS_SIZE) == '=');
+}
+
+// is parsing at a XML attribute
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLAttribute() {
+
+    return intag && *pc != '>' && *pc != '/';
+}
+
+// is parsing at a XML CDATA
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLCDATA() {
+
+    return *pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '[';
+}
+
+// is parsing at a XML comment
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLComment() {
+
+    return *pc == '<' && *std::next(pc) == '!' && *std::next(pc, 2) == '-' && *std::next(pc, 3) == '-';
+}
+
+// is parsing at characters before or after XML
+template <class Derived>
+bool XMLParserBase<Derived>::isCharactersBeforeOrAfter() {
+
+    return *pc != '<' && depth == 0;
+}
+
+// is parsing at a XML entity characters, which in structural mode are part of the text
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLEntityCharacters() {
+
+    return handlesCharacters() && *pc == '&';
+}
+
+// is parsing at a XML characters
+template <class Derived>
+bool XMLParserBase<Derived>::isXMLCharacters() {
+
+    return *pc != '<';
+}
+
+// parse declaration
+template <class Derived>
+void XMLParserBase<Derived>::parseDeclaration() {
+
+    //check for incomplete XML declaration
+    endpc = scanChar(pc, bufferEnd, '>');
+    if (endpc == bufferEnd) {
+        //refill the buffer
+        refill();
+        endpc = scanChar(pc, bufferEnd, '>');
+        if (endpc == bufferEnd) {
+            std::cerr << "parser error: Incomplete XML declaration\n";
+            exit(1);
+        }
+    }
+    std::advance(pc, strlen("<?"));
+    const char* ptargetend = scanNameEnd(pc, endpc);
+    const std::string_view target(pc, std::distance(pc, ptargetend));
+    PROFILE_HANDLER(derived().handleDeclaration(target));
+    pc = std::find_if_not(ptargetend, endpc, [] (char c) { return isspace(c); });
+}
+
+// parse required version
+template <class Derived>
+void XMLParserBase<Derived>::parseRequiredVersion() {
+
+    if (pc == endpc) {
+        std::cerr << "parser error: Missing space after before version in XML declaration\n";
+        exit(1);
+    }
+    const char* pnameend = scanChar(pc, endpc, '=');
+    const std::string_view attr(pc, std::distance(pc, pnameend));
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        std::cerr << "parser error: Invalid start delimiter for version in XML declaration\n";
+        exit(1);
+    }
+    std::advance(pc, 1);
+    const char* pvalueend = scanChar(pc, endpc, delim);
+    if (pvalueend == endpc) {
+        std::cerr << "parser error: Invalid end delimiter for version in XML declaration\n";
+        exit(1);
+    }
+    if (attr != "version") {
+        std::cerr << "parser error: Missing required first attribute version in XML declaration\n";
+        exit(1);
+    }
+    const std::string_view version(pc, std::distance(pc, pvalueend));
+    PROFILE_HANDLER(derived().handleRequiredVersion(version));
+    pc = std::next(pvalueend);
+    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
+}
+
+// parse a XML encoding
+template <class Derived>
+void XMLParserBase<Derived>::parseEncoding() {
+
+    if (pc == endpc) {
+        std::cerr << "parser error: Missing required encoding in XML declaration\n";
+        exit(1);
+    }
+    const char* pnameend = scanChar(pc, endpc, '=');
+    if (pnameend == endpc) {
+        std::cerr << "parser error: Incomple encoding in XML declaration\n";
+        exit(1);
+    }
+    const std::string_view attr2(pc, std::distance(pc, pnameend));
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim2 = *pc;
+    if (delim2 != '"' && delim2 != '\'') {
+        std::cerr << "parser error: Invalid end delimiter for encoding in XML declaration\n";
+        exit(1);
+    }
+    std::advance(pc, 1);
+    const char* pvalueend = scanChar(pc, endpc, delim2);
+    if (pvalueend == endpc) {
+        std::cerr << "parser error: Incomple encoding in XML declaration\n";
+        exit(1);
+    }
+    if (attr2 != "encoding") {
+        std::cerr << "parser error: Missing required encoding in XML declaration\n";
+        exit(1);
+    }
+    const std::string_view encoding(pc, std::distance(pc, pvalueend));
+    PROFILE_HANDLER(derived().handleEncoding(encoding));
+    pc = std::next(pvalueend);
+    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
+}
+
+// parse a XML standalone
+template <class Derived>
+void XMLParserBase<Derived>::parseStandalone() {
+
+    if (pc == endpc) {
+        std::cerr << "parser error: Missing required third attribute standalone in XML declaration\n";
+        exit(1);
+    }
+    const char* pnameend = scanChar(pc, endpc, '=');
+    const std::string_view attr3(pc, std::distance(pc, pnameend));
+    pc = pnameend;
+    std::advance(pc, 1);
+    char delim3 = *pc;
+    if (delim3 != '"' && delim3 != '\'') {
+        std::cerr << "parser error : Missing attribute standalone delimiter in XML declaration\n";
+        exit(1);
+    }
+    std::advance(pc, 1);
+    const char* pvalueend = scanChar(pc, endpc, delim3);
+    if (pvalueend == endpc) {
+        std::cerr << "parser error : Missing attribute standalone in XML declaration\n";
+        exit(1);
+    }
+    if (attr3 != "standalone") {
+        std::cerr << "parser error : Missing attribute standalone in XML declaration\n";
+        exit(1);
+    }
+    const std::string_view standalone(pc, std::distance(pc, pvalueend));
+    PROFILE_HANDLER(derived().handleStandalone(standalone));
+    pc = std::next(pvalueend);
+    pc = std::find_if_not(pc, endpc, [] (char c) { return isspace(c); });
+    std::advance(pc, strlen("?>"));
+    pc = std::find_if_not(pc, bufferEnd, [] (char c) { return isspace(c); });
+}
+
+// parse a XML end tag
+template <class Derived>
+void XMLParserBase<Derived>::parseEndTag() {
+
+    --depth;
+    endpc = scanChar(pc, bufferEnd, '>');
+    if (endpc == bufferEnd) {
+        refill();
+        endpc = scanChar(pc, bufferEnd, '>');
+        if (endpc == bufferEnd) {
+            std::cerr << "parser error: Incomplete element end tag\n";
+            exit(1);
+        }
+    }
+    tagStart = pc;
+    tagDepth = depth + 1;
+    if constexpr (!handlesEndTags()) {
+        // no handler, so the name is not needed, and its namespaces are closed at the next start tag,
+        // unless there are kept values to release at the end of a unit
+        if (!arena.empty()) {
+            const std::string_view qname(std::next(pc, 2), std::distance(std::next(pc, 2), scanNameEnd(std::next(pc, 2), endpc)));
+            const auto colonpos = qname.find(':');
+            if (names.id(colonpos == std::string_view::npos ? qname : qname.substr(colonpos + 1)) == ELEMENT_UNIT)
+                arena.reset();
+        }
+        pc = std::next(endpc);
+        return;
+    }
+    std::advance(pc, 2);
+    const char* pnameend = scanNameEnd(pc, std::next(endpc));
+    if (pnameend == std::next(endpc)) {
+        std::cerr << "parser error: Incomplete element end tag name\n";
+        exit(1);
+    }
+    const std::string_view qname(pc, std::distance(pc, pnameend));
+    const auto colonpos = qname.find(':');
+    std::string_view prefix;
+    if (colonpos != std::string_view::npos)
+        prefix = qname.substr(0, colonpos);
+    std::string_view local_name = qname;
+    if (colonpos != std::string_view::npos)
+        local_name = qname.substr(colonpos + 1);
+    // the declarations of the element itself are still in scope
+    namespaces.closeScopes(depth + 1);
+    const ElementID id = names.id(local_name);
+    const NamespaceID ns = namespaces.resolve(prefix);
+    PROFILE_HANDLER(derived().handleEndTag(qname, prefix, local_name, id, ns));
+    // values kept during the unit are released
+    if (id == ELEMENT_UNIT)
+        arena.reset();
+    pc = std::next(endpc);
+}
+
+/*
+    Parse a XML start tag. Handlers are passed the ID of the element
+    local name (see srcMLElements.hpp) and of the namespace (see
+    NamespaceNames.hpp), so they can dispatch on an integer instead of
+    comparing strings. The namespace declarations of the tag are bound
+    first, since they are in scope for its own name and attributes.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseStartTag() {
+
+    endpc = scanChar(pc, bufferEnd, '>');
+    if (endpc == bufferEnd) {
+        refill();
+        endpc = scanChar(pc, bufferEnd, '>');
+        if (endpc == bufferEnd) {
+            std::cerr << "parser error: Incomplete element start tag\n";
+            exit(1);
+        }
+    }
+    tagStart = pc;
+    tagDepth = depth;
+    std::advance(pc, 1);
+    const char* pnameend = scanNameEnd(pc, std::next(endpc));
+    if (pnameend == std::next(endpc)) {
+        std::cerr << "parser error : Unterminated start tag '" << std::string(pc, pnameend) << "'\n";
+        exit(1);
+    }
+    const std::string_view qname(pc, std::distance(pc, pnameend));
+    const auto colonpos = qname.find(':');
+    std::string_view prefix;
+    if (colonpos != std::string_view::npos)
+        prefix = qname.substr(0, colonpos);
+    std::string_view local_name = qname;
+    if (colonpos != std::string_view::npos)
+        local_name = qname.substr(colonpos + 1);
+    // declarations of this start tag are in scope for its name, so they are bound first
+    namespaces.closeScopes(depth);
+    if (*pnameend != '>') {
+        const std::string_view attributes(pnameend, std::distance(pnameend, endpc));
+        if (attributes.find("xmlns") != std::string_view::npos)
+            namespaces.declareAttributes(attributes, depth + 1);
+    }
+    const ElementID id = names.id(local_name);
+    const NamespaceID ns = namespaces.resolve(prefix);
+    PROFILE_HANDLER(derived().handleStartTag(qname, prefix, local_name, id, ns));
+    if constexpr (!handlesAttributes()) {
+        // structural mode, so the attributes are passed over with the rest of the tag
+        ++depth;
+        if (*std::prev(endpc) == '/')
+            --depth;
+        pc = std::next(endpc);
+        return;
+    }
+    pc = pnameend;
+    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
+    ++depth;
+    intag = true;
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        --depth;
+    }
+}
+
+// parse a XML namespace
+template <class Derived>
+void XMLParserBase<Derived>::parseNameSpace() {
+
+    const char* endpc = scanChar(pc, bufferEnd, '>');
+    const char* pnameend = scanChar(pc, std::next(endpc), '=');
+    if (pnameend == std::next(endpc)) {
+        std::cerr << "parser error : incomplete namespace\n";
+        exit(1);
+    }
+    std::advance(pc, XMLNS_SIZE);
+    std::string_view prefix;
+    if (*pc == ':') {
+        std::advance(pc, 1);
+        prefix = std::string_view(pc, std::distance(pc, pnameend));
+    }
+    pc = std::next(pnameend);
+    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
+    if (pc == std::next(endpc)) {
+        std::cerr << "parser error : incomplete namespace\n";
+        exit(1);
+    }
+    const char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        std::cerr << "parser error : incomplete namespace\n";
+        exit(1);
+    }
+    std::advance(pc, 1);
+    const char* pvalueend = scanChar(pc, std::next(endpc), delim);
+    if (pvalueend == std::next(endpc)) {
+        std::cerr << "parser error : incomplete namespace\n";
+        exit(1);
+    }
+    const std::string_view uri(pc, std::distance(pc, pvalueend));
+    PROFILE_HANDLER(derived().handleNameSpace(prefix, uri));
+    pc = std::next(pvalueend);
+    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        --depth;
+    }
+}
+
+// parse a XML attribute
+template <class Derived>
+void XMLParserBase<Derived>::parseAttribute() {
+
+    endpc = scanChar(pc, bufferEnd, '>');
+    const char* pnameend = scanChar(pc, std::next(endpc), '=');
+    if (pnameend == std::next(endpc))
+        exit(1);
+    const std::string_view qname(pc, std::distance(pc, pnameend));
+    const auto colonpos = qname.find(':');
+    std::string_view prefix;
+    if (colonpos != std::string_view::npos)
+        prefix = qname.substr(0, colonpos);
+    std::string_view local_name = qname;
+    if (colonpos != std::string_view::npos)
+        local_name = qname.substr(colonpos + 1);
+    pc = std::next(pnameend);
+    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
+    if (pc == bufferEnd) {
+        std::cerr << "parser error : attribute " << qname << " incomplete attribute\n";
+        exit(1);
+    }
+    char delim = *pc;
+    if (delim != '"' && delim != '\'') {
+        std::cerr << "parser error : attribute " << qname << " missing delimiter\n";
+        exit(1);
+    }
+    std::advance(pc, 1);
+    const char* pvalueend = scanChar(pc, std::next(endpc), delim);
+    if (pvalueend == std::next(endpc)) {
+        std::cerr << "parser error : attribute " << qname << " missing delimiter\n";
+        exit(1);
+    }
+    const std::string_view value(pc, std::distance(pc, pvalueend));
+    // unprefixed attributes are in no namespace
+    const NamespaceID ns = prefix.empty() ? NAMESPACE_NONE : namespaces.resolve(prefix);
+    PROFILE_HANDLER(derived().handleAttribute(qname, prefix, local_name, value, ns));
+    pc = std::next(pvalueend);
+    pc = std::find_if_not(pc, std::next(endpc), [] (char c) { return isspace(c); });
+    if (intag && *pc == '>') {
+        std::advance(pc, 1);
+        intag = false;
+    }
+    if (intag && *pc == '/' && *std::next(pc) == '>') {
+        std::advance(pc, 2);
+        intag = false;
+        --depth;
+    }
+}
+
+/*
+    Parse a XML CDATA. Content that does not fit in the buffer is
+    passed in chunks, each by its own call of parseNext(), in order,
+    to handleCDATAChunk(), with CHUNK_BEGIN on the first and CHUNK_END
+    on the last. Most fit, and are passed whole, with both flags. By
+    default, each chunk goes to handleCDATA(), so a handler that needs
+    the whole content handles the chunks. Memory is the buffer size
+    however large the content.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseCDATA() {
+
+    if (std::distance(pc, bufferEnd) < (std::ptrdiff_t) strlen("<![CDATA["))
+        refill();
+    std::advance(pc, strlen("<![CDATA["));
+    chunkFlags = CHUNK_BEGIN;
+    parseCDATAChunk();
+}
+
+/*
+    Parse the next chunk of a XML CDATA, up to its end, or to the end
+    of the buffer. Then the CDATA is continued by the next parseNext(),
+    after a refill.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseCDATAChunk() {
+
+    const std::string_view endcdata = "]]>";
+    endpc = std::search(pc, bufferEnd, endcdata.begin(), endcdata.end());
+    if (endpc == bufferEnd) {
+        if (inputComplete) {
+            std::cerr << "parser error : Unterminated CDATA\n";
+            exit(1);
+        }
+        // all but what may be the start of "]]>"
+        const char* pchunkend = std::prev(bufferEnd, std::min<std::ptrdiff_t>((std::ptrdiff_t) endcdata.size() - 1, std::distance(pc, bufferEnd)));
+        if (pchunkend != pc) {
+            PROFILE_HANDLER(derived().handleCDATAChunk(std::string_view(pc, std::distance(pc, pchunkend)), chunkFlags));
+            chunkFlags = CHUNK_CONTINUE;
+        }
+        pc = pchunkend;
+        inCDATA = true;
+        return;
+    }
+    inCDATA = false;
+    const std::string_view characters(pc, std::distance(pc, endpc));
+    PROFILE_HANDLER(derived().handleCDATAChunk(characters, chunkFlags | CHUNK_END));
+    pc = std::next(endpc, strlen("]]>"));
+}
+
+/*
+    Parse a XML comment. Content that does not fit in the buffer is
+    passed in chunks, each by its own call of parseNext(), to
+    handleCommentChunk(), as for CDATA.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseComment() {
+
+    std::advance(pc, strlen("<!--"));
+    chunkFlags = CHUNK_BEGIN;
+    parseCommentChunk();
+}
+
+/*
+    Parse the next chunk of a XML comment, up to its end, or to the end
+    of the buffer. Then the comment is continued by the next parseNext(),
+    after a refill.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseCommentChunk() {
+
+    const std::string_view endcomment = "-->";
+    endpc = std::search(pc, bufferEnd, endcomment.begin(), endcomment.end());
+    if (endpc == bufferEnd) {
+        if (inputComplete) {
+            std::cerr << "parser error : Unterminated XML comment\n";
+            exit(1);
+        }
+        // all but what may be the start of "-->"
+        const char* pchunkend = std::prev(bufferEnd, std::min<std::ptrdiff_t>((std::ptrdiff_t) endcomment.size() - 1, std::distance(pc, bufferEnd)));
+        if (pchunkend != pc) {
+            PROFILE_HANDLER(derived().handleCommentChunk(std::string_view(pc, std::distance(pc, pchunkend)), chunkFlags));
+            chunkFlags = CHUNK_CONTINUE;
+        }
+        pc = pchunkend;
+        inComment = true;
+        return;
+    }
+    inComment = false;
+    const std::string_view comment(pc, std::distance(pc, endpc));
+    PROFILE_HANDLER(derived().handleCommentChunk(comment, chunkFlags | CHUNK_END));
+    pc = std::next(endpc, strlen("-->"));
+    pc = std::find_if_not(pc, bufferEnd, [] (char c) { return isspace(c); });
+}
+
+// parse a XML character before or after XML
+template <class Derived>
+void XMLParserBase<Derived>::parseCharactersBeforeOrAfter() {
+
+    const char* pstart = pc;
+    pc = std::find_if_not(pc, bufferEnd, [] (char c) { return isspace(c); });
+    if (pc != bufferEnd && *pc != '<') {
+        std::cerr << "parser error : Start tag expected, '<' not found\n";
+        exit(1);
+    }
+    const std::string_view characters(pstart, std::distance(pstart, pc));
+    PROFILE_HANDLER(derived().handleCharactersBeforeOrAfter(characters));
+}
+
+/*
+    Parse a XML entity reference. The predefined entities, and numeric
+    character references in UTF-8, are decoded (see decodeEntities.hpp).
+    A '&' that is not a reference is passed as the characters "&".
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseEntityReference() {
+
+    const char* end;
+    int size;
+    EntityResult result = decodeEntity(pc, bufferEnd, entityCharacters, end, size);
+    // a refill may add fewer characters than the rest of the reference, e.g., from a pipe
+    while (result == ENTITY_INCOMPLETE && !inputComplete) {
+        refill();
+        result = decodeEntity(pc, bufferEnd, entityCharacters, end, size);
+    }
+    if (result == ENTITY_INCOMPLETE) {
+        std::cerr << "parser error : Incomplete entity reference, '" << std::string(pc, bufferEnd) << "'\n";
+        exit(1);
+    }
+    std::string_view characters;
+    if (result == ENTITY_DECODED) {
+        characters = std::string_view(entityCharacters, size);
+        pc = end;
+    } else {
+        // not a reference, so the '&' is characters
+        characters = "&";
+        std::advance(pc, 1);
+    }
+    PROFILE_HANDLER(derived().handleEntityReference(characters));
+}
+
+/*
+    Parse a XML characters. Text is passed to handleCharacters() in
+    parts, split at entity references and at the end of the buffer.
+    Without a characters handler, it is passed whole to handleText(),
+    so LOC is the count of '\n' in it, and the text size its length
+    less 3 for each &lt; and &gt;, and 4 for each &amp;.
+*/
+template <class Derived>
+void XMLParserBase<Derived>::parseCharacters() {
+
+    if constexpr (!handlesCharacters()) {
+        // structural mode, so the text up to the next markup is passed whole
+        const char* endpc = scanChar(pc, bufferEnd, '<');
+        if (endpc == bufferEnd) {
+            // an entity reference cut by the end of the buffer is left for the next text, after the refill
+            const std::ptrdiff_t tailSize = std::min<std::ptrdiff_t>(ENTITY_MAX_SIZE - 1, std::distance(pc, endpc));
+            const std::string_view tail(std::prev(endpc, tailSize), tailSize);
+            const std::size_t ampersand = tail.rfind('&');
+            if (ampersand != std::string_view::npos && tail.data() + ampersand != pc && tail.find(';', ampersand) == std::string_view::npos)
+                endpc = tail.data() + ampersand;
+        }
+        PROFILE_HANDLER(derived().handleText(std::string_view(pc, std::distance(pc, endpc))));
+        pc = endpc;
+        return;
+    }
+
+    const char* endpc = scanChars(pc, bufferEnd, '<', '&');
+    const std::string_view characters(pc, std::distance(pc, endpc));
+    PROFILE_HANDLER(derived().handleCharacters(characters));
+    pc = endpc;
+}
+
+#endif
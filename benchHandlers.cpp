@@ -0,0 +1,192 @@
+/*
+    benchHandlers.cpp
+
+    Compares parser throughput with std::function handlers (XMLParser)
+    against compile-time handlers (XMLParserBase), and against
+    compile-time handlers in structural mode, with only the text
+    handler. All count the same start tags and text as srcFacts. Heap
+    allocations during each parse are counted by replacing the global
+    operator new.
+
+    Usage: benchHandlers demo.xml
+*/
+
+#include "XMLParser.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// heap allocations so far
+static long allocations = 0;
+
+void* operator new(std::size_t size) {
+
+    ++allocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+
+    std::free(p);
+}
+
+// compile-time handlers
+class CountingParser : public XMLParserBase<CountingParser> {
+public:
+
+    void handleStartTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID /* ns */) {
+
+        if (id == ELEMENT_EXPR)
+            ++expr_count;
+        else if (id == ELEMENT_FUNCTION)
+            ++function_count;
+    }
+
+    void handleCharacters(std::string_view characters) {
+
+        loc += (int) std::count(characters.cbegin(), characters.cend(), '\n');
+        textsize += (int) characters.size();
+    }
+
+    void handleEntityReference(std::string_view characters) {
+
+        textsize += (int) characters.size();
+    }
+
+    // empty, but parsed, as by XMLParser, so this is the full parse
+    void handleEndTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID /* id */, NamespaceID /* ns */) {}
+    void handleAttribute(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, std::string_view /* value */, NamespaceID /* ns */) {}
+
+    int expr_count = 0;
+    int function_count = 0;
+    int loc = 0;
+    int textsize = 0;
+};
+
+// compile-time handlers in structural mode, with the text size less the entity references
+class StructuralParser : public XMLParserBase<StructuralParser> {
+public:
+
+    void handleStartTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID /* ns */) {
+
+        if (id == ELEMENT_EXPR)
+            ++expr_count;
+        else if (id == ELEMENT_FUNCTION)
+            ++function_count;
+    }
+
+    void handleText(std::string_view text) {
+
+        loc += (int) std::count(text.cbegin(), text.cend(), '\n');
+        textsize += (int) text.size();
+        for (auto pos = text.find('&'); pos != std::string_view::npos; pos = text.find('&', pos + 1)) {
+            if (text.compare(pos, 5, "&amp;") == 0)
+                textsize -= 4;
+            else if (text.compare(pos, 4, "&lt;") == 0 || text.compare(pos, 4, "&gt;") == 0)
+                textsize -= 3;
+        }
+    }
+
+    int expr_count = 0;
+    int function_count = 0;
+    int loc = 0;
+    int textsize = 0;
+};
+
+// put the file on stdin
+static void openInput(const char* filename) {
+
+    int fd = open(filename, O_RDONLY);
+    dup2(fd, 0);
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        std::cerr << "usage: benchHandlers file.xml\n";
+        return 1;
+    }
+    const char* filename = argv[1];
+
+    struct stat st;
+    if (stat(filename, &st) == -1) {
+        std::cerr << "benchHandlers: cannot open " << filename << '\n';
+        return 1;
+    }
+    const double megabytes = (double) st.st_size / (1024 * 1024);
+
+    // std::function handlers
+    openInput(filename);
+    int expr_count = 0;
+    int function_count = 0;
+    int loc = 0;
+    int textsize = 0;
+    auto start = std::chrono::steady_clock::now();
+    long startAllocations = allocations;
+    {
+        XMLParser parser(nullptr, nullptr, nullptr, nullptr, nullptr,
+            [&](const std::string& local_name) {
+                if (local_name == "expr")
+                    ++expr_count;
+                else if (local_name == "function")
+                    ++function_count;
+            },
+            nullptr, nullptr, nullptr, nullptr, nullptr,
+            [&](const std::string& characters) {
+                textsize += (int) characters.size();
+            },
+            [&](const std::string& characters) {
+                loc += (int) std::count(characters.cbegin(), characters.cend(), '\n');
+                textsize += (int) characters.size();
+            });
+        parser.parse();
+    }
+    const std::chrono::duration<double> functionTime = std::chrono::steady_clock::now() - start;
+    const long functionAllocations = allocations - startAllocations;
+
+    // compile-time handlers
+    openInput(filename);
+    start = std::chrono::steady_clock::now();
+    startAllocations = allocations;
+    CountingParser parser;
+    parser.parse();
+    const std::chrono::duration<double> templateTime = std::chrono::steady_clock::now() - start;
+    const long templateAllocations = allocations - startAllocations;
+
+    // compile-time handlers in structural mode
+    openInput(filename);
+    start = std::chrono::steady_clock::now();
+    startAllocations = allocations;
+    StructuralParser structuralParser;
+    structuralParser.parse();
+    const std::chrono::duration<double> structuralTime = std::chrono::steady_clock::now() - start;
+    const long structuralAllocations = allocations - startAllocations;
+
+    if (parser.expr_count != expr_count || parser.function_count != function_count || parser.loc != loc || parser.textsize != textsize
+        || structuralParser.expr_count != expr_count || structuralParser.function_count != function_count
+        || structuralParser.loc != loc || structuralParser.textsize != textsize) {
+        std::cerr << "benchHandlers: counts differ\n";
+        return 1;
+    }
+
+    std::cout << "| Handlers | Seconds | MB/s | Allocations |\n";
+    std::cout << "|:-----|-----:|-----:|-----:|\n";
+    std::cout << "| std::function | " << functionTime.count() << " | " << megabytes / functionTime.count() << " | " << functionAllocations << " |\n";
+    std::cout << "| template | " << templateTime.count() << " | " << megabytes / templateTime.count() << " | " << templateAllocations << " |\n";
+    std::cout << "| template, structural | " << structuralTime.count() << " | " << megabytes / structuralTime.count() << " | " << structuralAllocations << " |\n";
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+    benchInput.cpp
+
+    Compares parser throughput of the memory-mapped input path
+    against the buffered read path and the asynchronous read path.
+    The same file is parsed once from a regular file on stdin
+    (mapped) and twice through a pipe on stdin (read, async).
+
+    Usage: benchInput demo.xml
+*/
+
+#include "XMLParserBase.hpp"
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// parser with no handlers
+class InputParser : public XMLParserBase<InputParser> {
+public:
+    using XMLParserBase::XMLParserBase;
+};
+
+// parse whatever is on stdin, returning the elapsed seconds
+static double timeParse(bool asyncRead) {
+
+    const auto start = std::chrono::steady_clock::now();
+    InputParser parser(asyncRead);
+    parser.parse();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+// parse the file through a pipe on stdin fed by a writer thread, returning the elapsed seconds
+static double timePipeParse(const char* filename, bool asyncRead) {
+
+    int fds[2];
+    if (pipe(fds) == -1) {
+        std::cerr << "benchInput: cannot create pipe\n";
+        exit(1);
+    }
+    std::thread writer([filename, out = fds[1]]() {
+        int in = open(filename, O_RDONLY);
+        static char block[1 << 16];
+        ssize_t n;
+        while ((n = read(in, block, sizeof(block))) > 0) {
+            for (ssize_t written = 0; written < n; ) {
+                ssize_t w = write(out, block + written, (size_t) (n - written));
+                if (w <= 0)
+                    break;
+                written += w;
+            }
+        }
+        close(in);
+        close(out);
+    });
+    dup2(fds[0], 0);
+    close(fds[0]);
+    const double elapsed = timeParse(asyncRead);
+    writer.join();
+
+    return elapsed;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        std::cerr << "usage: benchInput file.xml\n";
+        return 1;
+    }
+    const char* filename = argv[1];
+
+    struct stat st;
+    if (stat(filename, &st) == -1) {
+        std::cerr << "benchInput: cannot open " << filename << '\n';
+        return 1;
+    }
+    const double megabytes = (double) st.st_size / (1024 * 1024);
+
+    // mapped: stdin is the regular file
+    int fd = open(filename, O_RDONLY);
+    dup2(fd, 0);
+    close(fd);
+    const double mappedTime = timeParse(false);
+
+    // read and async: stdin is a pipe
+    const double readTime = timePipeParse(filename, false);
+    const double asyncTime = timePipeParse(filename, true);
+
+    std::cout << "| Input | Seconds | MB/s |\n";
+    std::cout << "|:-----|-----:|-----:|\n";
+    std::cout << "| mmap | " << mappedTime << " | " << megabytes / mappedTime << " |\n";
+    std::cout << "| read | " << readTime << " | " << megabytes / readTime << " |\n";
+    std::cout << "| async | " << asyncTime << " | " << megabytes / asyncTime << " |\n";
+
+    return 0;
+}
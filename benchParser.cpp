@@ -0,0 +1,535 @@
+/*
+    benchParser.cpp
+
+    Benchmark suite for the parsers. Measures XMLParser, XMLCursor, and
+    the xml_parser.cpp parsing functions over demo.xml and synthetic
+    inputs, each stressing one path:
+
+    * text: long runs of characters
+    * attributes: start tags with many attributes
+    * nesting: deeply nested elements
+    * entities: text with many entity references
+    * cdata: large CDATA sections
+    * comments: large comments
+
+    For demo.xml, XMLCursor is also measured skipping the body of each
+    block, as a query for declarations only would.
+
+    For each parser and input it reports MB/s, ns/event, ns for each
+    event type, and heap allocations/MB, taking the fastest of several
+    runs. The cost of each event type is sampled: one event in
+    SAMPLE_INTERVAL starts the clock, and the time to the next event is
+    the cost of its type, less the cost of reading the clock. Heap
+    allocations are counted by replacing the global operator new. The
+    event counts of each parser must match those of XMLParser before a
+    time is reported. Results are written as JSON so runs of two builds
+    can be compared.
+
+    Usage: benchParser [-o results.json] [--size MB] [--runs N] [demo.xml]
+*/
+
+#include "XMLParser.hpp"
+#include "XMLCursor.hpp"
+#include "xml_parser.hpp"
+#include "refillBuffer.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// heap allocations so far
+static long allocations = 0;
+
+void* operator new(std::size_t size) {
+
+    ++allocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+
+    std::free(p);
+}
+
+namespace {
+
+// event types, in the order of the XMLParser constructor
+enum Event { DECLARATION, VERSION, ENCODING, STANDALONE, END_TAG, START_TAG, NAMESPACE, ATTRIBUTE,
+             CDATA, COMMENT, BEFORE_OR_AFTER, ENTITY_REFERENCE, CHARACTERS, EVENT_COUNT };
+
+const char* const EVENT_NAMES[EVENT_COUNT] = { "declaration", "version", "encoding", "standalone", "endTag", "startTag",
+    "namespace", "attribute", "cdata", "comment", "charactersBeforeOrAfter", "entityReference", "characters" };
+
+using EventCounts = std::array<long, EVENT_COUNT>;
+using EventTimes = std::array<double, EVENT_COUNT>;
+
+// one measurement
+struct Result {
+    std::string input;
+    std::string parser;
+    long bytes = 0;
+    double seconds = 0;
+    long allocations = 0;
+    EventCounts events{};
+    // sampled ns of each event type, and the number of samples
+    EventTimes eventNanoseconds{};
+    EventCounts eventSamples{};
+};
+
+// counts of each event type, with the time of one event in SAMPLE_INTERVAL
+class EventTimer {
+public:
+
+    // prime, so the samples do not follow the period of a repeated fragment
+    static constexpr long SAMPLE_INTERVAL = 61;
+
+    // count an event, with the time since the last sample start if there is one
+    void add(Event event) {
+
+        ++events[event];
+        if (timing) {
+            nanoseconds[event] += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            ++sampled[event];
+            timing = false;
+        }
+        if (++count % SAMPLE_INTERVAL == 0) {
+            timing = true;
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    // event counts
+    const EventCounts& counts() const { return events; }
+
+    // number of sampled events of each type
+    const EventCounts& samples() const { return sampled; }
+
+    // sampled ns of each event type, less the cost of reading the clock
+    EventTimes averages(double clockNanoseconds) const {
+
+        EventTimes result{};
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (sampled[event])
+                result[event] = std::max(0.0, nanoseconds[event] / (double) sampled[event] - clockNanoseconds);
+        }
+        return result;
+    }
+
+private:
+    EventCounts events{};
+    EventCounts sampled{};
+    EventTimes nanoseconds{};
+    long count = 0;
+    bool timing = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+// least ns between two reads of the clock
+double clockCost() {
+
+    double least = 1e9;
+    for (int i = 0; i < 1000; ++i) {
+        const auto first = std::chrono::steady_clock::now();
+        const auto second = std::chrono::steady_clock::now();
+        least = std::min(least, std::chrono::duration<double, std::nano>(second - first).count());
+    }
+    return least;
+}
+
+// total of the event counts
+long totalEvents(const EventCounts& events) {
+
+    long total = 0;
+    for (auto count : events)
+        total += count;
+    return total;
+}
+
+// put the file on stdin
+void openInput(const std::string& filename) {
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "benchParser: cannot open " << filename << '\n';
+        exit(1);
+    }
+    dup2(fd, 0);
+    close(fd);
+}
+
+// parse stdin with XMLParser, counting each event type
+void parseXMLParser(EventTimer& timer) {
+
+    auto counter = [&timer](Event event) {
+        return [&timer, event](const std::string&) { timer.add(event); };
+    };
+    XMLParser parser(counter(DECLARATION), counter(VERSION), counter(ENCODING), counter(STANDALONE),
+                     counter(END_TAG), counter(START_TAG), counter(NAMESPACE), counter(ATTRIBUTE),
+                     counter(CDATA), counter(COMMENT), counter(BEFORE_OR_AFTER), counter(ENTITY_REFERENCE),
+                     counter(CHARACTERS));
+    parser.parse();
+}
+
+// parse stdin with XMLCursor, counting each token kind
+void parseXMLCursor(EventTimer& timer) {
+
+    static_assert((int) XMLToken::END_OF_INPUT == EVENT_COUNT, "token kinds in the order of the events");
+
+    XMLCursor cursor;
+    for (auto token = &cursor.next(); token->kind != XMLToken::END_OF_INPUT; token = &cursor.next())
+        timer.add((Event) token->kind);
+}
+
+// parse stdin with XMLCursor, skipping the content of blocks
+void parseXMLCursorSkipBlock(EventTimer& timer) {
+
+    XMLCursor cursor;
+    for (auto token = &cursor.next(); token->kind != XMLToken::END_OF_INPUT; token = &cursor.next()) {
+        timer.add((Event) token->kind);
+        if (token->kind == XMLToken::START_TAG && token->id == ELEMENT_BLOCK)
+            cursor.skipSubtree();
+    }
+}
+
+/*
+    Parse stdin with the xml_parser.cpp functions, counting each event
+    type. The functions take the parser state by value, so the depth and
+    whether the parse is inside a start tag are tracked here from the
+    characters just before the returned position. As in XMLParserBase,
+    at the end of input the last few characters are parsed in place.
+    Text split by a refill is counted once, as the mapped input of the
+    other parsers has no refills.
+
+    @param timer Updated with the event counts and times
+*/
+void parseXMLFunctions(EventTimer& timer) {
+
+    long total = 0;
+    int depth = 0;
+    bool intag = false;
+    bool inputComplete = false;
+    bool inCharacters = false;
+    std::string url;
+    std::string buffer;
+    InputSource input = InputSource::fromFD(0);
+    std::string::const_iterator pc = buffer.cend();
+    while (true) {
+        while (!inputComplete && std::distance(pc, buffer.cend()) < 5) {
+            const auto leftover = std::distance(pc, buffer.cend());
+            pc = refillBuffer(pc, buffer, total, input);
+            if (pc == buffer.cend()) {
+                // at the end of input, the unprocessed characters were moved to the start of the buffer
+                inputComplete = true;
+                buffer.resize(leftover);
+                pc = buffer.cbegin();
+            }
+        }
+        if (pc == buffer.cend())
+            break;
+        const bool continuesCharacters = inCharacters;
+        inCharacters = false;
+        if (isXMLDeclaration(pc)) {
+            auto endpc = std::find(pc, buffer.cend(), '>');
+            pc = parseDeclaration(buffer, input, pc, endpc, total);
+            pc = parseRequiredVersion(pc, endpc);
+            pc = parseEncoding(pc, endpc, endpc, endpc);
+            pc = parseStandalone(buffer, pc, endpc, endpc, endpc);
+            timer.add(DECLARATION);
+            timer.add(VERSION);
+            timer.add(ENCODING);
+            timer.add(STANDALONE);
+        } else if (isXMLEndTag(pc)) {
+            pc = parseEndTag(buffer, input, pc, pc, depth, total);
+            --depth;
+            timer.add(END_TAG);
+        } else if (isXMLCDATA(pc)) {
+            pc = parseCDATA(buffer, input, pc, pc, 0, 0, total);
+            timer.add(CDATA);
+        } else if (isXMLComment(pc)) {
+            pc = parseComment(buffer, input, pc, pc, total);
+            timer.add(COMMENT);
+        } else if (isXMLStartTag(pc)) {
+            pc = parseStartTag(buffer, input, depth, total, intag, pc, pc, pc, pc, "");
+            intag = *std::prev(pc) != '>';
+            if (intag || *std::prev(pc, 2) != '/')
+                ++depth;
+            timer.add(START_TAG);
+        } else if (isXMLNamespace(buffer, intag, pc) || isXMLAttribute(intag, pc)) {
+            const bool isNamespace = isXMLNamespace(buffer, intag, pc);
+            pc = isNamespace ? parseNameSpace(buffer, intag, pc, pc, pc, pc) : parseAttribute(buffer, url, intag, pc, pc, pc, pc);
+            intag = *std::prev(pc) != '>';
+            if (!intag && *std::prev(pc, 2) == '/')
+                --depth;
+            timer.add(isNamespace ? NAMESPACE : ATTRIBUTE);
+        } else if (isCharactersBeforeOrAfter(depth, pc)) {
+            pc = parseCharactersBeforeOrAfter(buffer, pc);
+            timer.add(BEFORE_OR_AFTER);
+        } else if (isXMLEntityCharacters(pc)) {
+            pc = parseEntityReference(buffer, input, pc, 0, total);
+            timer.add(ENTITY_REFERENCE);
+        } else if (isXMLCharacters(pc)) {
+            pc = parseCharacters(buffer, pc, 0, 0);
+            // text only stops short of markup or a reference at the end of the buffer
+            if (!continuesCharacters)
+                timer.add(CHARACTERS);
+            inCharacters = true;
+        }
+    }
+}
+
+/*
+    Time the fastest of several parses of a file.
+
+    @param input Name of the input
+    @param filename File to parse
+    @param parser Name of the parser
+    @param parse Parses stdin, counting and sampling events
+    @param runs Number of parses
+    @return Measurement of the fastest parse
+*/
+template <class Parse>
+Result measure(const std::string& input, const std::string& filename, const char* parser, Parse parse, int runs) {
+
+    static const double clockNanoseconds = clockCost();
+
+    struct stat st;
+    stat(filename.c_str(), &st);
+
+    Result result;
+    result.input = input;
+    result.parser = parser;
+    result.bytes = (long) st.st_size;
+    for (int run = 0; run < runs; ++run) {
+        openInput(filename);
+        EventTimer timer;
+        const long startAllocations = allocations;
+        const auto start = std::chrono::steady_clock::now();
+        parse(timer);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < result.seconds) {
+            result.seconds = elapsed.count();
+            result.allocations = allocations - startAllocations;
+            result.events = timer.counts();
+            result.eventNanoseconds = timer.averages(clockNanoseconds);
+            result.eventSamples = timer.samples();
+        }
+    }
+
+    return result;
+}
+
+/*
+    Generate a synthetic document of about size bytes by repeating a
+    fragment inside a root element.
+
+    @param filename File to write
+    @param fragment Repeated content of the root element
+    @param size Approximate size in bytes
+*/
+void writeSynthetic(const std::string& filename, const std::string& fragment, long size) {
+
+    std::ofstream out(filename, std::ios::binary);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n";
+    out << "<root xmlns=\"http://www.srcML.org/srcML/src\">\n";
+    for (long written = 0; written < size; written += (long) fragment.size())
+        out << fragment;
+    out << "</root>\n";
+}
+
+// repeat a string
+std::string repeat(const std::string& s, int count) {
+
+    std::string result;
+    result.reserve(s.size() * count);
+    for (int i = 0; i < count; ++i)
+        result += s;
+    return result;
+}
+
+// synthetic inputs as name and fragment
+std::vector<std::pair<std::string, std::string>> syntheticInputs() {
+
+    const std::string line = "    for (int i = 0; i != count; ++i) total += values[i] * weights[i];\n";
+    std::string attributes = "<e";
+    for (int i = 0; i < 8; ++i)
+        attributes += " attr" + std::to_string(i) + "=\"value" + std::to_string(i) + "\"";
+    attributes += "/>\n";
+
+    return {
+        { "text", "<s>" + repeat(line, 64) + "</s>\n" },
+        { "attributes", attributes },
+        { "nesting", repeat("<d>", 500) + "x" + repeat("</d>", 500) + "\n" },
+        { "entities", "<s>" + repeat("a &lt; b &amp;&amp; c &gt; d ", 32) + "</s>\n" },
+        { "cdata", "<s><![CDATA[" + repeat(line, 256) + "]]></s>\n" },
+        { "comments", "<!--" + repeat(line, 256) + "-->\n" },
+    };
+}
+
+// JSON string with quotes and backslashes escaped
+std::string jsonString(const std::string& s) {
+
+    std::string result = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    result += '"';
+    return result;
+}
+
+// results as JSON
+std::string toJSON(const std::vector<Result>& results, int runs) {
+
+    std::ostringstream out;
+    out << "{\n";
+    out << "  \"runs\": " << runs << ",\n";
+    out << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        const double megabytes = (double) result.bytes / (1024 * 1024);
+        const long events = totalEvents(result.events);
+        out << "    {\n";
+        out << "      \"input\": " << jsonString(result.input) << ",\n";
+        out << "      \"parser\": " << jsonString(result.parser) << ",\n";
+        out << "      \"bytes\": " << result.bytes << ",\n";
+        out << "      \"seconds\": " << result.seconds << ",\n";
+        out << "      \"MBPerSecond\": " << megabytes / result.seconds << ",\n";
+        out << "      \"events\": " << events << ",\n";
+        out << "      \"nsPerEvent\": " << (events ? result.seconds * 1e9 / (double) events : 0) << ",\n";
+        out << "      \"allocations\": " << result.allocations << ",\n";
+        out << "      \"allocationsPerMB\": " << (double) result.allocations / megabytes << ",\n";
+        out << "      \"eventCounts\": {";
+        for (int event = 0; event < EVENT_COUNT; ++event)
+            out << (event ? ", " : " ") << jsonString(EVENT_NAMES[event]) << ": " << result.events[event];
+        out << " },\n";
+        out << "      \"nsPerEventType\": {";
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            out << (event ? ", " : " ") << jsonString(EVENT_NAMES[event]) << ": ";
+            if (result.eventSamples[event])
+                out << result.eventNanoseconds[event];
+            else
+                out << "null";
+        }
+        out << " }\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n";
+    out << "}\n";
+
+    return out.str();
+}
+
+}
+
+int main(int argc, char* argv[]) {
+
+    std::string outputFilename;
+    std::string demoFilename;
+    long size = 8 * 1024 * 1024;
+    int runs = 3;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outputFilename = argv[++i];
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            size = std::atol(argv[++i]) * 1024 * 1024;
+        } else if (std::strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && demoFilename.empty()) {
+            demoFilename = argv[i];
+        } else {
+            std::cerr << "usage: benchParser [-o results.json] [--size MB] [--runs N] [demo.xml]\n";
+            return 1;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+
+    // inputs as name and filename, with generated files removed at the end
+    std::vector<std::pair<std::string, std::string>> inputs;
+    if (!demoFilename.empty())
+        inputs.emplace_back("demo", demoFilename);
+    std::vector<std::string> generated;
+    for (const auto& synthetic : syntheticInputs()) {
+        const std::string filename = "bench-" + synthetic.first + ".xml";
+        writeSynthetic(filename, synthetic.second, size);
+        inputs.emplace_back(synthetic.first, filename);
+        generated.push_back(filename);
+    }
+
+    // the parsers of the full input must find the same events as XMLParser, or their times are not comparable
+    std::vector<Result> results;
+    bool sameCounts = true;
+    for (const auto& input : inputs) {
+        const Result reference = measure(input.first, input.second, "XMLParser", parseXMLParser, runs);
+        results.push_back(reference);
+        const std::pair<const char*, void (*)(EventTimer&)> parsers[] = {
+            { "XMLCursor", parseXMLCursor },
+            { "xml_parser", parseXMLFunctions },
+        };
+        for (const auto& parser : parsers) {
+            results.push_back(measure(input.first, input.second, parser.first, parser.second, runs));
+            if (results.back().events != reference.events) {
+                std::cerr << "benchParser: " << parser.first << " event counts differ from XMLParser on " << input.first << '\n';
+                sameCounts = false;
+            }
+        }
+        if (input.first == "demo")
+            results.push_back(measure(input.first, input.second, "XMLCursor skip block", parseXMLCursorSkipBlock, runs));
+    }
+    for (const auto& filename : generated)
+        std::remove(filename.c_str());
+    if (!sameCounts)
+        return 1;
+
+    const std::string json = toJSON(results, runs);
+    if (outputFilename.empty()) {
+        std::cout << json;
+        return 0;
+    }
+    std::ofstream(outputFilename) << json;
+
+    // summary table
+    std::cout << "| Input | Parser | MB/s | ns/event | allocations/MB |\n";
+    std::cout << "|:-----|:-----|-----:|-----:|-----:|\n";
+    for (const auto& result : results) {
+        const double megabytes = (double) result.bytes / (1024 * 1024);
+        const long events = totalEvents(result.events);
+        std::cout << "| " << result.input << " | " << result.parser << " | " << megabytes / result.seconds
+                  << " | " << (events ? result.seconds * 1e9 / (double) events : 0)
+                  << " | " << (double) result.allocations / megabytes << " |\n";
+    }
+
+    // sampled cost of each event type, for the types with samples
+    std::cout << "\n| Input | Parser | Event | Count | ns/event |\n";
+    std::cout << "|:-----|:-----|:-----|-----:|-----:|\n";
+    for (const auto& result : results) {
+        for (int event = 0; event < EVENT_COUNT; ++event) {
+            if (result.eventSamples[event] == 0)
+                continue;
+            std::cout << "| " << result.input << " | " << result.parser << " | " << EVENT_NAMES[event]
+                      << " | " << result.events[event] << " | " << result.eventNanoseconds[event] << " |\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+/*
+    decodeEntities.cpp
+
+    Implement XML entity reference decoding functions
+
+    References are the five predefined entities, &lt; &gt; &amp; &quot;
+    and &apos;, and the numeric character references &#NN; and &#xNN;,
+    which are encoded in UTF-8. The names are in a small table, and the
+    digits are values in a table by character.
+
+    A reference is never shorter than its characters, e.g., &#x10000;
+    is 9 bytes for 4 bytes of UTF-8, so the output of decoding text is
+    never past the input, and text can be decoded in place.
+ */
+
+#include "decodeEntities.hpp"
+#include "scanDelimiters.hpp"
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+// predefined entity name and its character
+struct PredefinedEntity {
+    std::string_view name;
+    char character;
+};
+
+const PredefinedEntity predefinedEntities[] = {
+    { "lt",   '<'  },
+    { "gt",   '>'  },
+    { "amp",  '&'  },
+    { "quot", '"'  },
+    { "apos", '\'' },
+};
+
+// value of each hexadecimal digit, or -1 for other characters
+constexpr std::array<signed char, 256> digitValues = [] {
+
+    std::array<signed char, 256> values{};
+    for (int c = 0; c < 256; ++c)
+        values[c] = -1;
+    for (int c = '0'; c <= '9'; ++c)
+        values[c] = (signed char) (c - '0');
+    for (int c = 'a'; c <= 'f'; ++c)
+        values[c] = (signed char) (c - 'a' + 10);
+    for (int c = 'A'; c <= 'F'; ++c)
+        values[c] = (signed char) (c - 'A' + 10);
+    return values;
+}();
+
+// encode a code point in UTF-8, returning the number of bytes
+int encodeUTF8(unsigned long codepoint, char* out) {
+
+    if (codepoint < 0x80) {
+        out[0] = (char) codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char) (0xC0 | (codepoint >> 6));
+        out[1] = (char) (0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char) (0xE0 | (codepoint >> 12));
+        out[1] = (char) (0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char) (0xF0 | (codepoint >> 18));
+    out[1] = (char) (0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char) (0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char) (0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+}
+
+/*
+    Decode the entity reference at first. A reference without its ';'
+    before last, and shorter than the longest reference, is incomplete,
+    e.g., cut by the end of the buffer. Other text at a '&' is invalid,
+    e.g., an unknown name, a code point out of range, or a bare '&'.
+    The characters are written only after the reference is read, so
+    out may overlap the reference.
+
+    @param first Start of the reference, at the '&'
+    @param last End of the input
+    @param out Where to write the characters, at least ENTITY_MAX_CHARACTERS
+    @param end Set to the end of the reference, after the ';', if decoded
+    @param size Set to the number of characters written, if decoded
+    @return ENTITY_DECODED, ENTITY_INCOMPLETE, or ENTITY_INVALID
+*/
+EntityResult decodeEntity(const char* first, const char* last, char* out, const char*& end, int& size) {
+
+    // the name, or the '#' and digits, up to the ';'
+    const char* limit = last - first > ENTITY_MAX_SIZE ? first + ENTITY_MAX_SIZE : last;
+    const char* pname = first + 1;
+    const char* pnameend = pname;
+    while (pnameend != limit && (std::isalnum((unsigned char) *pnameend) || *pnameend == '#'))
+        ++pnameend;
+    if (pnameend == last && last - first < ENTITY_MAX_SIZE)
+        return ENTITY_INCOMPLETE;
+    if (pnameend == limit || *pnameend != ';')
+        return ENTITY_INVALID;
+    const std::string_view name(pname, (std::size_t) (pnameend - pname));
+
+    if (name.size() > 1 && name[0] == '#') {
+        // numeric character reference, decimal or hexadecimal
+        const bool hex = name[1] == 'x';
+        const std::string_view digits = name.substr(hex ? 2 : 1);
+        const int base = hex ? 16 : 10;
+        if (digits.empty())
+            return ENTITY_INVALID;
+        unsigned long codepoint = 0;
+        for (const char c : digits) {
+            const int digit = digitValues[(unsigned char) c];
+            if (digit < 0 || digit >= base)
+                return ENTITY_INVALID;
+            codepoint = codepoint * base + digit;
+            if (codepoint > 0x10FFFF)
+                return ENTITY_INVALID;
+        }
+        // no null character or surrogates
+        if (codepoint == 0 || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+            return ENTITY_INVALID;
+        size = encodeUTF8(codepoint, out);
+        end = pnameend + 1;
+        return ENTITY_DECODED;
+    }
+
+    for (const auto& entity : predefinedEntities) {
+        if (name == entity.name) {
+            out[0] = entity.character;
+            size = 1;
+            end = pnameend + 1;
+            return ENTITY_DECODED;
+        }
+    }
+
+    return ENTITY_INVALID;
+}
+
+/*
+    Decode the text in [first, last) into out. The text between
+    references is copied in bulk, one run at a time. A '&' that is
+    not a reference, including one cut by last, is copied as is.
+
+    @param first Start of the text
+    @param last End of the text
+    @param out Where to write the decoded text, at least last - first, or first
+    @return End of the decoded text
+*/
+char* decodeEntities(const char* first, const char* last, char* out) {
+
+    while (first != last) {
+
+        // run of text up to the next reference
+        const char* pentity = scanChar(first, last, '&');
+        if (out != first)
+            std::memmove(out, first, (std::size_t) (pentity - first));
+        out += pentity - first;
+        if (pentity == last)
+            break;
+
+        const char* end;
+        int size;
+        if (decodeEntity(pentity, last, out, end, size) == ENTITY_DECODED) {
+            out += size;
+            first = end;
+        } else {
+            *out++ = '&';
+            first = pentity + 1;
+        }
+    }
+
+    return out;
+}
+
+/*
+    Decode the text in [first, last) in place, e.g., a copy of an
+    attribute value.
+
+    @param first Start of the text
+    @param last End of the text
+    @return New end of the text
+*/
+char* decodeEntitiesInPlace(char* first, char* last) {
+
+    return decodeEntities(first, last, first);
+}
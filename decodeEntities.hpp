@@ -0,0 +1,28 @@
+/*
+    decodeEntities.hpp
+
+    Declaration of XML entity reference decoding functions
+*/
+
+#ifndef INCLUDE_DECODEENTITIES_HPP
+#define INCLUDE_DECODEENTITIES_HPP
+
+// longest entity reference decoded, from the '&' through the ';', e.g., "&#x0010FFFF;" with room for leading zeros
+constexpr int ENTITY_MAX_SIZE = 16;
+
+// longest characters of a decoded entity reference, a code point in UTF-8
+constexpr int ENTITY_MAX_CHARACTERS = 4;
+
+// result of decoding one entity reference
+enum EntityResult { ENTITY_DECODED, ENTITY_INCOMPLETE, ENTITY_INVALID };
+
+// decode the entity reference at first, i.e., at a '&', into out, with the end of the reference and the size of the characters
+EntityResult decodeEntity(const char* first, const char* last, char* out, const char*& end, int& size);
+
+// decode the text in [first, last) into out, which may be first, returning the end of the output
+char* decodeEntities(const char* first, const char* last, char* out);
+
+// decode the text in [first, last) in place, returning the new end
+char* decodeEntitiesInPlace(char* first, char* last);
+
+#endif
@@ -0,0 +1,35 @@
+/*
+    fnvHash.hpp
+
+    FNV-1a hashes of bytes, usable at compile time
+*/
+
+#ifndef INCLUDE_FNVHASH_HPP
+#define INCLUDE_FNVHASH_HPP
+
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a 64-bit hash of the bytes
+constexpr std::uint64_t fnvHash64(std::string_view bytes) {
+
+    std::uint64_t h = 14695981039346656037ull;
+    for (char c : bytes) {
+        h ^= (unsigned char) c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// FNV-1a 32-bit hash of the bytes, with the offset basis xored with a seed
+constexpr std::uint32_t fnvHash32(std::string_view bytes, std::uint32_t seed = 0) {
+
+    std::uint32_t h = 2166136261u ^ seed;
+    for (char c : bytes) {
+        h ^= (unsigned char) c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#endif
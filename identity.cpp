@@ -4,13 +4,53 @@
     An identity transformation of XML. The input is XML and the
     output is the equivalent XML.
 
-    Limitation:
-    * CDATA is not complete
+    The input is parsed, and the parser passes each part of the raw
+    input to handleInput() before its buffer is reused, or for mapped
+    input, about every buffer size. The parts are forwarded as spans,
+    without copying, and written with writev, or with vmsplice when
+    the output is a pipe and the input is mapped. So output is written
+    as the parse goes, and not all at the end.
+
+    Usage: identity < file.xml > copy.xml
 */
 
-#include <iostream>
+#include "XMLParserBase.hpp"
+#include "SpanWriter.hpp"
+
+// parser that forwards the input unchanged
+class identityParser : public XMLParserBase<identityParser> {
+public:
+
+    // constructor
+    identityParser() {
+
+        // decompressed input is in buffers that are reused
+        writer.setStableInput(mapped && !reader);
+    }
+
+    // forward the input
+    void handleInput(std::string_view input) {
+
+        // the buffer is refilled after this returns, and mapped input is passed in parts to write as they come
+        writer.forward(input);
+        writer.flush();
+    }
+
+    // write any pending output
+    void flush() {
+
+        writer.flush();
+    }
+
+private:
+    SpanWriter writer;
+};
 
 int main() {
 
+    identityParser parser;
+    parser.parse();
+    parser.flush();
+
     return 0;
 }
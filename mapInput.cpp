@@ -0,0 +1,154 @@
+/*
+    mapInput.cpp
+
+    Implement memory-mapped input functions
+ */
+
+#include "mapInput.hpp"
+#include <errno.h>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#include <stdio.h>
+#endif
+
+/*
+    Map the input file into memory for sequential access.
+    Only regular files are mapped. Pipes, terminals, and empty
+    files are left to the buffered read path.
+
+    @param fd File descriptor of the input
+    @param begin Set to the start of the mapped input
+    @param end Set to the end of the mapped input
+    @return true if the input was mapped
+*/
+bool mapInput(int fd, const char*& begin, const char*& end) {
+
+#if !defined(_MSC_VER)
+    // only regular files can be mapped
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0)
+        return false;
+
+    // map from the current file offset so a partially-consumed stdin is respected
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == -1 || offset >= st.st_size)
+        return false;
+    const long pagesize = sysconf(_SC_PAGESIZE);
+    const off_t pageoffset = offset - (offset % pagesize);
+    const size_t length = (size_t) (st.st_size - pageoffset);
+
+    void* region = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, pageoffset);
+    if (region == MAP_FAILED)
+        return false;
+
+    // input is parsed front to back exactly once, so have the kernel
+    // read ahead of the parse and free pages behind it early. No
+    // MADV_WILLNEED, which would read the whole file in at once.
+    madvise(region, length, MADV_SEQUENTIAL);
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, pageoffset, (off_t) length, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    begin = static_cast<const char*>(region) + (offset - pageoffset);
+    end = static_cast<const char*>(region) + length;
+
+    return true;
+#else
+    (void) fd;
+    (void) begin;
+    (void) end;
+
+    return false;
+#endif
+}
+
+/*
+    Unmap input previously mapped with mapInput().
+
+    @param begin Start of the mapped input
+    @param end End of the mapped input
+*/
+void unmapInput(const char* begin, const char* end) {
+
+#if !defined(_MSC_VER)
+    const long pagesize = sysconf(_SC_PAGESIZE);
+    const char* region = begin - ((unsigned long) begin % pagesize);
+    munmap((void*) region, (size_t) (end - region));
+#else
+    (void) begin;
+    (void) end;
+#endif
+}
+
+/*
+    Current offset of the input file, e.g., of standard input
+    positioned to resume a parse.
+
+    @param fd File descriptor of the input
+    @return The offset, or 0 for input that cannot seek, e.g., a pipe
+*/
+long inputOffset(int fd) {
+
+#if !defined(_MSC_VER)
+    const off_t offset = lseek(fd, 0, SEEK_CUR);
+    return offset == -1 ? 0 : (long) offset;
+#else
+    (void) fd;
+
+    return 0;
+#endif
+}
+
+/*
+    Size of the input file, e.g., to check it against an index of it.
+
+    @param fd File descriptor of the input
+    @return The size, or -1 if the input is not a regular file
+*/
+long inputSize(int fd) {
+
+#if !defined(_MSC_VER)
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return -1;
+    return (long) st.st_size;
+#else
+    return (long) _filelengthi64(fd);
+#endif
+}
+
+/*
+    Read part of the input file at an offset. On POSIX, the file offset
+    is not changed, so this can be called from several threads.
+
+    @param fd File descriptor of the input, a regular file
+    @param data Buffer for the bytes
+    @param size Number of bytes to read
+    @param offset Offset in the file to read from
+    @return false on a read error or a short read
+*/
+bool readInputAt(int fd, char* data, long size, long offset) {
+
+#if !defined(_MSC_VER)
+    while (size > 0) {
+        const ssize_t numbytes = pread(fd, data, (size_t) size, (off_t) offset);
+        if (numbytes == -1 && errno == EINTR)
+            continue;
+        if (numbytes <= 0)
+            return false;
+        data += numbytes;
+        size -= (long) numbytes;
+        offset += (long) numbytes;
+    }
+    return true;
+#else
+    if (_lseeki64(fd, offset, SEEK_SET) == -1)
+        return false;
+    return _read(fd, data, (unsigned int) size) == size;
+#endif
+}
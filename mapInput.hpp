@@ -0,0 +1,25 @@
+/*
+    mapInput.hpp
+
+    Declaration of memory-mapped input functions
+*/
+
+#ifndef INCLUDE_MAPINPUT_HPP
+#define INCLUDE_MAPINPUT_HPP
+
+// map the input file into memory
+bool mapInput(int fd, const char*& begin, const char*& end);
+
+// unmap the input file
+void unmapInput(const char* begin, const char* end);
+
+// current offset of the input file, or 0 if it cannot seek
+long inputOffset(int fd);
+
+// size of the input file, or -1 if it is not a regular file
+long inputSize(int fd);
+
+// read part of the input file at an offset, without moving the file offset
+bool readInputAt(int fd, char* data, long size, long offset);
+
+#endif
@@ -5,22 +5,25 @@
  */
 
 #include "refillBuffer.hpp"
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <string>
-#include <errno.h>
-#if !defined(_MSC_VER)
-#include <sys/uio.h>
-#include <unistd.h>
-#define READ read
-#else
-#include <BaseTsd.h>
-#include <io.h>
-typedef SSIZE_T ssize_t;
-#define READ _read
-#endif
 
-const int BUFFER_SIZE = 16 * 16 * 4096;
+/*
+    Refill the buffer from standard input preserving the unused data.
+
+    @param pc Iterator to current position in buffer
+    @param buffer Container for characters
+    @param totalBytes Updated total bytes read
+    @return Iterator to beginning of refilled buffer
+*/
+std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes) {
+
+    InputSource input = InputSource::fromFD(0);
+
+    return refillBuffer(pc, buffer, totalBytes, input);
+}
 
 /*
     Refill the buffer preserving the unused data.
@@ -30,10 +33,10 @@ const int BUFFER_SIZE = 16 * 16 * 4096;
     @param pc Iterator to current position in buffer
     @param buffer Container for characters
     @param totalBytes Updated total bytes read
+    @param input Source of the data
     @return Iterator to beginning of refilled buffer
 */
-
-std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes) {
+std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes, InputSource& input) {
 
     // find number of unprocessed characters [pc, buffer.cend())
     auto d = std::distance(pc, buffer.cend());
@@ -41,15 +44,13 @@ std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::st
     // move unprocessed characters, [pc, buffer.cend()), to start of the buffer
     std::copy(pc, buffer.cend(), buffer.begin());
 
+    // restore full size after a short read so the read below stays in bounds
+    if (buffer.size() < (std::string::size_type) BUFFER_SIZE)
+        buffer.resize(BUFFER_SIZE);
+
     // read in trying to read whole blocks
-    ssize_t numbytes = 0;
-    while (((numbytes = READ(0, (void*)(buffer.data() + d), (size_t)(BUFFER_SIZE - d))) == (ssize_t) -1) &&
-        (errno == EINTR)) {
-    }
-    // error in read
-    if (numbytes == -1)
-        return buffer.cend();
-    // EOF
+    const long numbytes = input.read(buffer.data() + d, (long) (BUFFER_SIZE - d));
+    // EOF, or error in read
     if (numbytes == 0)
         return buffer.cend();
 
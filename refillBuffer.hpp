@@ -7,9 +7,16 @@
 #ifndef INCLUDE_REFILLBUFFER_HPP
 #define INCLUDE_REFILLBUFFER_HPP
 
+#include "InputSource.hpp"
 #include <string>
 
-// refill buffer
+// size of the input buffer, and of each block of the reader thread (see AsyncReader.hpp)
+constexpr int BUFFER_SIZE = 16 * 16 * 4096;
+
+// refill buffer from standard input
 std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes);
 
+// refill buffer from a file or callback source
+std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes, InputSource& input);
+
 #endif
@@ -0,0 +1,491 @@
+/*
+    scanDelimiters.cpp
+
+    Implement vectorized delimiter scanning and counting functions
+
+    Each scan compares 16 (SSE2), 32 (AVX2), or 64 (AVX-512) bytes
+    at a time against the delimiter set, and finishes the tail one
+    character at a time. SSE2 is the x86-64 baseline. AVX2 and
+    AVX-512 are selected at startup from CPUID. Other architectures
+    use the scalar scans.
+
+    Counts compare the same way, and add the popcount of the match
+    mask. SSE2 has no popcount, so it instead subtracts the matches,
+    which are -1, from byte counters, and sums them every 255 blocks,
+    before they can overflow.
+
+    The kernel can be forced with the environment variable
+    SRCFACTS_SCAN=scalar|sse2|avx2|avx512, e.g., to compare the
+    output of the vector kernels against the scalar kernel.
+ */
+
+#include "scanDelimiters.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86 1
+#define SCAN_DISPATCH 1
+#include <immintrin.h>
+#elif defined(_M_X64)
+#define SCAN_X86 1
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// name end is a space, '>', or '/'
+inline bool isNameEnd(char c) {
+
+    return c == ' ' || (unsigned char) (c - '\t') <= '\r' - '\t' || c == '>' || c == '/';
+}
+
+// index of the lowest set bit of a non-zero mask
+inline int lowestBit(unsigned int mask) {
+
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int) index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/*
+    Scalar kernels
+*/
+
+const char* scanCharsScalar(const char* first, const char* last, char c1, char c2) {
+
+    for (; first != last; ++first) {
+        if (*first == c1 || *first == c2)
+            return first;
+    }
+    return last;
+}
+
+const char* scanNameEndScalar(const char* first, const char* last) {
+
+    for (; first != last; ++first) {
+        if (isNameEnd(*first))
+            return first;
+    }
+    return last;
+}
+
+long countCharScalar(const char* first, const char* last, char c) {
+
+    long count = 0;
+    for (; first != last; ++first)
+        count += *first == c;
+    return count;
+}
+
+long countCodePointsScalar(const char* first, const char* last) {
+
+    long count = 0;
+    for (; first != last; ++first)
+        count += ((unsigned char) *first & 0xC0) != 0x80;
+    return count;
+}
+
+#if defined(SCAN_X86)
+
+/*
+    SSE2 kernels
+*/
+
+const char* scanCharsSSE2(const char* first, const char* last, char c1, char c2) {
+
+    const __m128i d1 = _mm_set1_epi8(c1);
+    const __m128i d2 = _mm_set1_epi8(c2);
+    for (; last - first >= 16; first += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*) first);
+        const __m128i match = _mm_or_si128(_mm_cmpeq_epi8(v, d1), _mm_cmpeq_epi8(v, d2));
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(match);
+        if (mask)
+            return first + lowestBit(mask);
+    }
+    return scanCharsScalar(first, last, c1, c2);
+}
+
+const char* scanNameEndSSE2(const char* first, const char* last) {
+
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i spaceRange = _mm_set1_epi8('\r' - '\t');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i slash = _mm_set1_epi8('/');
+    for (; last - first >= 16; first += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*) first);
+        // '\t' through '\r' as an unsigned range check
+        const __m128i offset = _mm_sub_epi8(v, tab);
+        const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, spaceRange), offset);
+        __m128i match = _mm_or_si128(_mm_cmpeq_epi8(v, space), control);
+        match = _mm_or_si128(match, _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, slash)));
+        const unsigned int mask = (unsigned int) _mm_movemask_epi8(match);
+        if (mask)
+            return first + lowestBit(mask);
+    }
+    return scanNameEndScalar(first, last);
+}
+
+// sum of the byte counters
+inline long sumCounts(__m128i counts) {
+
+    const __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    return _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+}
+
+// end of the whole blocks from first, at most 255, so byte counters do not overflow
+const char* countBlockEnd(const char* first, const char* last) {
+
+    return first + std::min<long>((last - first) & ~15L, 255 * 16);
+}
+
+long countCharSSE2(const char* first, const char* last, char c) {
+
+    const __m128i d = _mm_set1_epi8(c);
+    long count = 0;
+    while (last - first >= 16) {
+        __m128i counts = _mm_setzero_si128();
+        for (const char* blockEnd = countBlockEnd(first, last); first != blockEnd; first += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*) first);
+            counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(v, d));
+        }
+        count += sumCounts(counts);
+    }
+    return count + countCharScalar(first, last, c);
+}
+
+long countCodePointsSSE2(const char* first, const char* last) {
+
+    // continuation bytes 0x80 through 0xBF are signed -128 through -65
+    const __m128i continuation = _mm_set1_epi8(-65);
+    long count = 0;
+    while (last - first >= 16) {
+        __m128i counts = _mm_setzero_si128();
+        for (const char* blockEnd = countBlockEnd(first, last); first != blockEnd; first += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*) first);
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(v, continuation));
+        }
+        count += sumCounts(counts);
+    }
+    return count + countCodePointsScalar(first, last);
+}
+
+#endif
+
+#if defined(SCAN_DISPATCH)
+
+/*
+    AVX2 kernels
+*/
+
+__attribute__((target("avx2")))
+const char* scanCharsAVX2(const char* first, const char* last, char c1, char c2) {
+
+    const __m256i d1 = _mm256_set1_epi8(c1);
+    const __m256i d2 = _mm256_set1_epi8(c2);
+    for (; last - first >= 32; first += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*) first);
+        const __m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(v, d1), _mm256_cmpeq_epi8(v, d2));
+        const unsigned int mask = (unsigned int) _mm256_movemask_epi8(match);
+        if (mask)
+            return first + lowestBit(mask);
+    }
+    return scanCharsSSE2(first, last, c1, c2);
+}
+
+__attribute__((target("avx2")))
+const char* scanNameEndAVX2(const char* first, const char* last) {
+
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i spaceRange = _mm256_set1_epi8('\r' - '\t');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i slash = _mm256_set1_epi8('/');
+    for (; last - first >= 32; first += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*) first);
+        // '\t' through '\r' as an unsigned range check
+        const __m256i offset = _mm256_sub_epi8(v, tab);
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, spaceRange), offset);
+        __m256i match = _mm256_or_si256(_mm256_cmpeq_epi8(v, space), control);
+        match = _mm256_or_si256(match, _mm256_or_si256(_mm256_cmpeq_epi8(v, gt), _mm256_cmpeq_epi8(v, slash)));
+        const unsigned int mask = (unsigned int) _mm256_movemask_epi8(match);
+        if (mask)
+            return first + lowestBit(mask);
+    }
+    return scanNameEndSSE2(first, last);
+}
+
+__attribute__((target("avx2,popcnt")))
+long countCharAVX2(const char* first, const char* last, char c) {
+
+    const __m256i d = _mm256_set1_epi8(c);
+    long count = 0;
+    for (; last - first >= 32; first += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*) first);
+        count += _mm_popcnt_u32((unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, d)));
+    }
+    return count + countCharSSE2(first, last, c);
+}
+
+__attribute__((target("avx2,popcnt")))
+long countCodePointsAVX2(const char* first, const char* last) {
+
+    const __m256i continuation = _mm256_set1_epi8(-65);
+    long count = 0;
+    for (; last - first >= 32; first += 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*) first);
+        count += _mm_popcnt_u32((unsigned int) _mm256_movemask_epi8(_mm256_cmpgt_epi8(v, continuation)));
+    }
+    return count + countCodePointsSSE2(first, last);
+}
+
+/*
+    AVX-512 kernels
+*/
+
+__attribute__((target("avx512f,avx512bw")))
+const char* scanCharsAVX512(const char* first, const char* last, char c1, char c2) {
+
+    const __m512i d1 = _mm512_set1_epi8(c1);
+    const __m512i d2 = _mm512_set1_epi8(c2);
+    for (; last - first >= 64; first += 64) {
+        const __m512i v = _mm512_loadu_si512((const void*) first);
+        const unsigned long long mask = _mm512_cmpeq_epi8_mask(v, d1) | _mm512_cmpeq_epi8_mask(v, d2);
+        if (mask)
+            return first + __builtin_ctzll(mask);
+    }
+    return scanCharsAVX2(first, last, c1, c2);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+const char* scanNameEndAVX512(const char* first, const char* last) {
+
+    const __m512i space = _mm512_set1_epi8(' ');
+    const __m512i tab = _mm512_set1_epi8('\t');
+    const __m512i spaceRange = _mm512_set1_epi8('\r' - '\t');
+    const __m512i gt = _mm512_set1_epi8('>');
+    const __m512i slash = _mm512_set1_epi8('/');
+    for (; last - first >= 64; first += 64) {
+        const __m512i v = _mm512_loadu_si512((const void*) first);
+        // '\t' through '\r' as an unsigned range check
+        const unsigned long long control = _mm512_cmple_epu8_mask(_mm512_sub_epi8(v, tab), spaceRange);
+        const unsigned long long mask = control | _mm512_cmpeq_epi8_mask(v, space)
+            | _mm512_cmpeq_epi8_mask(v, gt) | _mm512_cmpeq_epi8_mask(v, slash);
+        if (mask)
+            return first + __builtin_ctzll(mask);
+    }
+    return scanNameEndAVX2(first, last);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+long countCharAVX512(const char* first, const char* last, char c) {
+
+    const __m512i d = _mm512_set1_epi8(c);
+    long count = 0;
+    for (; last - first >= 64; first += 64) {
+        const __m512i v = _mm512_loadu_si512((const void*) first);
+        count += (long) _mm_popcnt_u64(_mm512_cmpeq_epi8_mask(v, d));
+    }
+    return count + countCharAVX2(first, last, c);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+long countCodePointsAVX512(const char* first, const char* last) {
+
+    const __m512i continuation = _mm512_set1_epi8(-65);
+    long count = 0;
+    for (; last - first >= 64; first += 64) {
+        const __m512i v = _mm512_loadu_si512((const void*) first);
+        count += (long) _mm_popcnt_u64(_mm512_cmpgt_epi8_mask(v, continuation));
+    }
+    return count + countCodePointsAVX2(first, last);
+}
+
+#endif
+
+/*
+    Kernel selection
+*/
+
+struct ScanKernel {
+    const char* name;
+    const char* (*scanChars)(const char*, const char*, char, char);
+    const char* (*scanNameEnd)(const char*, const char*);
+    long (*countChar)(const char*, const char*, char);
+    long (*countCodePoints)(const char*, const char*);
+};
+
+const ScanKernel scalarKernel = { "scalar", scanCharsScalar, scanNameEndScalar, countCharScalar, countCodePointsScalar };
+#if defined(SCAN_X86)
+const ScanKernel sse2Kernel = { "sse2", scanCharsSSE2, scanNameEndSSE2, countCharSSE2, countCodePointsSSE2 };
+#endif
+#if defined(SCAN_DISPATCH)
+const ScanKernel avx2Kernel = { "avx2", scanCharsAVX2, scanNameEndAVX2, countCharAVX2, countCodePointsAVX2 };
+const ScanKernel avx512Kernel = { "avx512", scanCharsAVX512, scanNameEndAVX512, countCharAVX512, countCodePointsAVX512 };
+#endif
+
+// select the widest kernel the CPU supports, unless overridden
+const ScanKernel& selectKernel() {
+
+    const char* forced = std::getenv("SRCFACTS_SCAN");
+    if (forced && std::strcmp(forced, "scalar") == 0)
+        return scalarKernel;
+
+#if defined(SCAN_DISPATCH)
+    __builtin_cpu_init();
+    // the counts of the wider kernels use popcnt, which every CPU with AVX2 has
+    const bool hasPOPCNT = __builtin_cpu_supports("popcnt");
+    const bool hasAVX512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && hasPOPCNT;
+    const bool hasAVX2 = __builtin_cpu_supports("avx2") && hasPOPCNT;
+    if (forced && std::strcmp(forced, "sse2") == 0)
+        return sse2Kernel;
+    if (forced && std::strcmp(forced, "avx2") == 0 && hasAVX2)
+        return avx2Kernel;
+    if (hasAVX512 && (!forced || std::strcmp(forced, "avx512") == 0))
+        return avx512Kernel;
+    if (hasAVX2)
+        return avx2Kernel;
+    return sse2Kernel;
+#elif defined(SCAN_X86)
+    return sse2Kernel;
+#else
+    return scalarKernel;
+#endif
+}
+
+// set the kernel in use to the selected kernel
+void resolveKernel();
+
+// first scans, which select the kernel, e.g., for a scan during the static initialization of another file
+const char* scanCharsFirst(const char* first, const char* last, char c1, char c2) {
+
+    resolveKernel();
+    return scanChars(first, last, c1, c2);
+}
+
+const char* scanNameEndFirst(const char* first, const char* last) {
+
+    resolveKernel();
+    return scanNameEnd(first, last);
+}
+
+long countCharFirst(const char* first, const char* last, char c) {
+
+    resolveKernel();
+    return countChar(first, last, c);
+}
+
+long countCodePointsFirst(const char* first, const char* last) {
+
+    resolveKernel();
+    return countCodePoints(first, last);
+}
+
+/*
+    Kernel in use. It is constant initialized with the first scans, so
+    it is valid before any dynamic initialization, and is replaced by
+    the selected kernel at startup, or by the first scan if earlier.
+    Scans then call through its pointers, with no check.
+*/
+ScanKernel kernel = { nullptr, scanCharsFirst, scanNameEndFirst, countCharFirst, countCodePointsFirst };
+
+// set the kernel in use to the selected kernel
+void resolveKernel() {
+
+    kernel = selectKernel();
+}
+
+// select the kernel at startup, before any parse
+[[maybe_unused]] const bool kernelSelected = (resolveKernel(), true);
+
+}
+
+/*
+    Find the first c in [first, last).
+    The C library memchr is already vectorized for a single character.
+
+    @param first Start of the range
+    @param last End of the range
+    @param c Character to find
+    @return Pointer to the first c, or last if not found
+*/
+const char* scanChar(const char* first, const char* last, char c) {
+
+    const void* p = std::memchr(first, c, (size_t) (last - first));
+
+    return p ? static_cast<const char*>(p) : last;
+}
+
+/*
+    Find the first c1 or c2 in [first, last).
+
+    @param first Start of the range
+    @param last End of the range
+    @param c1 First delimiter
+    @param c2 Second delimiter
+    @return Pointer to the first delimiter, or last if not found
+*/
+const char* scanChars(const char* first, const char* last, char c1, char c2) {
+
+    return kernel.scanChars(first, last, c1, c2);
+}
+
+/*
+    Find the end of a name, i.e., the first whitespace, '>', or '/'.
+    Whitespace is as for isspace() in the "C" locale.
+
+    @param first Start of the range
+    @param last End of the range
+    @return Pointer to the first name end, or last if not found
+*/
+const char* scanNameEnd(const char* first, const char* last) {
+
+    return kernel.scanNameEnd(first, last);
+}
+
+/*
+    Count c in [first, last), in place, e.g., newlines for lines of code.
+
+    @param first Start of the range
+    @param last End of the range
+    @param c Character to count
+    @return Number of c
+*/
+long countChar(const char* first, const char* last, char c) {
+
+    return kernel.countChar(first, last, c);
+}
+
+/*
+    Count the UTF-8 code points in [first, last), in place, i.e., the
+    bytes that are not continuation bytes. Input is not validated, so
+    each invalid lead byte is a code point.
+
+    @param first Start of the range
+    @param last End of the range
+    @return Number of code points
+*/
+long countCodePoints(const char* first, const char* last) {
+
+    return kernel.countCodePoints(first, last);
+}
+
+/*
+    Name of the scanning kernel in use.
+
+    @return "scalar", "sse2", "avx2", or "avx512"
+*/
+const char* scanKernel() {
+
+    if (!kernel.name)
+        resolveKernel();
+
+    return kernel.name;
+}
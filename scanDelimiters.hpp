@@ -0,0 +1,28 @@
+/*
+    scanDelimiters.hpp
+
+    Declaration of vectorized delimiter scanning and counting functions
+*/
+
+#ifndef INCLUDE_SCANDELIMITERS_HPP
+#define INCLUDE_SCANDELIMITERS_HPP
+
+// find the first c in [first, last), or last
+const char* scanChar(const char* first, const char* last, char c);
+
+// find the first c1 or c2 in [first, last), or last
+const char* scanChars(const char* first, const char* last, char c1, char c2);
+
+// find the end of a name: the first space, '>', or '/' in [first, last), or last
+const char* scanNameEnd(const char* first, const char* last);
+
+// number of c in [first, last), e.g., newlines for lines of code
+long countChar(const char* first, const char* last, char c);
+
+// number of UTF-8 code points in [first, last), i.e., bytes that are not continuation bytes
+long countCodePoints(const char* first, const char* last);
+
+// name of the scanning kernel in use, e.g., "avx2"
+const char* scanKernel();
+
+#endif
@@ -0,0 +1,106 @@
+/*
+    splitUnits.cpp
+
+    Implement functions to split a srcML archive on unit boundaries
+
+    A srcML archive is a root unit whose children are the units of
+    each file. Units do not nest any deeper, and a literal "<unit" in
+    source code is escaped as "&lt;unit", so every "<unit" start tag
+    after the root start tag is the start of a file unit. The split
+    does not track markup, so the archive must not have a "<unit" in
+    a comment or CDATA section, and units must have no prefix.
+ */
+
+#include "splitUnits.hpp"
+#include "scanDelimiters.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+namespace {
+
+const std::string_view UNIT_START = "<unit";
+
+}
+
+/*
+    Find the end of the root start tag, skipping the XML declaration,
+    comments, and whitespace before it.
+
+    @param begin Start of the document
+    @param end End of the document
+    @return Pointer just past the '>' of the root start tag, or nullptr
+*/
+const char* findRootStartTagEnd(const char* begin, const char* end) {
+
+    const char* pc = begin;
+    while (true) {
+        pc = scanChar(pc, end, '<');
+        if (std::distance(pc, end) < 2)
+            return nullptr;
+        if (pc[1] == '?') {
+            // XML declaration or processing instruction
+            const std::string_view endpi = "?>";
+            pc = std::search(pc, end, endpi.begin(), endpi.end());
+        } else if (pc[1] == '!') {
+            // comment or DOCTYPE
+            pc = scanChar(pc, end, '>');
+        } else {
+            // root start tag
+            pc = scanChar(pc, end, '>');
+            return pc == end ? nullptr : std::next(pc);
+        }
+        if (pc == end)
+            return nullptr;
+        std::advance(pc, 1);
+    }
+}
+
+/*
+    Find the start tag of each nested unit. The range is searched
+    in chunks in parallel. Every "<unit" followed by a space or '>'
+    is taken as a start tag at depth 1, so the range must not have
+    one inside a comment or CDATA section, and a prefixed unit,
+    e.g., "<src:unit", is not found.
+
+    @param begin Start of the range, after the root start tag
+    @param end End of the range
+    @param pool Workers to search with
+    @return Pointers to the '<' of each unit start tag, in order
+*/
+std::vector<const char*> findUnitStarts(const char* begin, const char* end, WorkStealingPool& pool) {
+
+    const std::size_t length = (std::size_t) std::distance(begin, end);
+    const std::size_t chunkCount = std::max<std::size_t>(1, std::min<std::size_t>(pool.size() * 4, length / (1 << 20)));
+    const std::size_t chunkSize = length / chunkCount + 1;
+    std::vector<std::vector<const char*>> chunkStarts(chunkCount);
+
+    const std::boyer_moore_horspool_searcher<std::string_view::const_iterator> searcher(UNIT_START.begin(), UNIT_START.end());
+    pool.run(chunkCount, [&](std::size_t chunk, int) {
+
+        // a match may start in this chunk and end in the next
+        const char* chunkBegin = begin + std::min(length, chunk * chunkSize);
+        const char* chunkEnd = begin + std::min(length, (chunk + 1) * chunkSize);
+        const char* searchEnd = begin + std::min(length, (chunk + 1) * chunkSize + UNIT_START.size());
+
+        const char* pc = chunkBegin;
+        while (true) {
+            pc = std::search(pc, searchEnd, searcher);
+            if (pc >= chunkEnd)
+                break;
+            // "<unit" followed by space or '>', not a longer name such as "<units"
+            const char* pnameend = std::next(pc, UNIT_START.size());
+            if (pnameend != end && (*pnameend == '>' || isspace((unsigned char) *pnameend)))
+                chunkStarts[chunk].push_back(pc);
+            pc = pnameend;
+        }
+    });
+
+    std::vector<const char*> starts;
+    for (const auto& found : chunkStarts)
+        starts.insert(starts.end(), found.begin(), found.end());
+
+    return starts;
+}
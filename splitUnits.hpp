@@ -0,0 +1,19 @@
+/*
+    splitUnits.hpp
+
+    Declaration of functions to split a srcML archive on unit boundaries
+*/
+
+#ifndef INCLUDE_SPLITUNITS_HPP
+#define INCLUDE_SPLITUNITS_HPP
+
+#include "WorkStealingPool.hpp"
+#include <vector>
+
+// find the end of the root start tag
+const char* findRootStartTagEnd(const char* begin, const char* end);
+
+// find the start tag of each nested unit
+std::vector<const char*> findUnitStarts(const char* begin, const char* end, WorkStealingPool& pool);
+
+#endif
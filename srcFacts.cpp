@@ -7,110 +7,751 @@
     Code includes an almost-complete XML parser. Limitations:
     * DTD declarations are not handled
     * Well-formedness is not checked
+
+    Usage: srcFacts [-j threads] [--async] [--code-points] [--paths file] [--units ndjson|csv]
+                    [--checkpoint file [--checkpoint-every MB]] [--resume file] < project.xml
+           srcFacts [-j threads] --build-index project.idx < project.xml
+           srcFacts [-j threads] [--units ndjson|csv] --index project.idx --select pattern... < project.xml
+           srcFacts [-j threads] [--units ndjson|csv] project.xml... | --batch < paths.txt
+
+    With -j and a regular file as input, the file units of the archive
+    are parsed in parallel and the counts are merged. The report is
+    the same as for a serial run. The archive is split on each "<unit",
+    so it must not have one in a comment or CDATA section.
+
+    Lines of code and characters are counted in place in the input
+    buffer, with vectorized counts. Characters are bytes of text, or
+    with --code-points, UTF-8 code points, so that the count is right
+    for source with non-ASCII characters.
+
+    With --paths, each element path pattern of the file, one per line,
+    e.g., class//function, is counted, and is a row of the report
+    (see PathPatterns.hpp). The patterns are compiled into one
+    automaton, so any number of them are counted in the same pass.
+
+    With --async and a pipe as input, e.g., from unzip -p, input is
+    read on a separate thread while it is parsed.
+
+    Compressed input, e.g., srcFacts < project.xml.zip, is detected and
+    decompressed on a separate thread while it is parsed. Supported are
+    gzip and zip (with zlib) and zstd (with libzstd).
+
+    With --units ndjson or --units csv, the report is instead one record
+    per file unit, keyed by its filename (or url) attribute, written as
+    the unit ends. With -j, records are in the order units finish.
+
+    With --checkpoint, the state of the parse and the counts so far are
+    saved to the file at the start of a file unit, every 64 MB of input
+    by default, and at the end of the archive. With --resume, a parse
+    of the same input, or of the archive with more units appended,
+    continues from the checkpoint instead of from the start, with the
+    same report as a parse from the start. Unit records are only output
+    for the units after the checkpoint. Checkpoints are for serial
+    parses of uncompressed input, so -j is ignored, and resuming needs
+    a regular file as input.
+
+    With --build-index, the offset, length, filename, language, and
+    hash of each file unit of the archive are written to an index file
+    (see UnitIndex.hpp). With --index and one or more --select, only
+    the units whose filename equals a pattern, or matches it as a glob,
+    e.g., *.cpp, are read with pread and parsed. The report is of
+    those units, and srcML is the number of bytes read.
+
+    With one or more archive paths, or with --batch and a list of paths
+    on standard input, one per line, the archives are parsed at the same
+    time, -j at a time, each whole by one thread, largest first. There
+    is a report for each archive, in the order given, and then a report
+    of the total. With --units, the records of all the archives are in
+    one report.
 */
 
-#include "XMLParser.hpp"
+#include "XMLParserBase.hpp"
+#include "WorkStealingPool.hpp"
+#include "splitUnits.hpp"
+#include "mapInput.hpp"
+#include "Decompressor.hpp"
+#include "UnitReport.hpp"
+#include "Checkpoint.hpp"
+#include "UnitIndex.hpp"
+#include "PathPatterns.hpp"
+#include "scanDelimiters.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
-#if !defined(_MSC_VER)
-#include <sys/uio.h>
-#include <unistd.h>
-#else
-#include <BaseTsd.h>
-#include <io.h>
-typedef SSIZE_T ssize_t;
-#endif
-
-const int BUFFER_SIZE = 16 * 16 * 4096;
-
-// call to refill buffer
-std::string::const_iterator refillBuffer(std::string::const_iterator pc, std::string& buffer, long& totalBytes);
+// patterns of --paths, loaded before any parse
+static PathPatterns pathPatterns;
 
-int main() {
+// counts for the report
+struct Facts {
     std::string url;
-    int textsize = 0;
-    int loc = 0;
-    bool intag = false;
-    int expr_count = 0;
-    int function_count = 0;
-    int class_count = 0;
-    int file_count = 0;
-    int decl_count = 0;
-    int comment_count = 0;
-    int return_count = 0;;
-    int literal_string_count = 0;
-    int line_comment_count = 0;
-    int depth = 0;
     long total = 0;
-    std::string buffer(BUFFER_SIZE, ' ');
-    auto pc = buffer.cbegin();
-    
-    // class variable
-    XMLParser parser(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
-    
-//    XMLParser parser(
-//
-//                [&](const std::string&local_name){
-//                     //const std::string local_name = name.substr(0, name.find('_'));
-//                     if (local_name == "expr")
-//                         ++expr_count;
-//                     else if (local_name == "function")
-//                         ++function_count;
-//                     else if (local_name == "decl")
-//                         ++decl_count;
-//                     else if (local_name == "class")
-//                         ++class_count;
-//                     else if (local_name == "unit" && depth > 0)
-//                         ++file_count;
-//                     else if (local_name == "comment")
-//                         ++comment_count;
-//                     else if (local_name == "return")
-//                         ++return_count;
-//                     else if (local_name == "literal")
-//                         ++literal_string_count;
-//                     else if (local_name == "line_comment")
-//                         ++line_comment_count;
-//                    }
-//                    );
-
-           // std::string local_namebase;
-            const std::string local_name;
-            if (local_name == "expr")
-                ++expr_count;
-            else if (local_name == "function")
-                ++function_count;
-            else if (local_name == "decl")
-                ++decl_count;
-            else if (local_name == "class")
-                ++class_count;
-            else if (local_name == "unit" && depth > 0)
-                ++file_count;
-            else if (local_name == "comment")
-                ++comment_count;
-            else if (local_name == "return")
-                ++return_count;
-            else if (local_name == "literal")
-                ++literal_string_count;
-            else if (local_name == "line_comment")
-                ++line_comment_count;
-    
-    // output the report
-    std::cout << "# srcFacts: " << url <<'\n';
+    long textsize = 0;
+    long loc = 0;
+    long file_count = 0;
+    // start tags of each srcML element, indexed by element ID
+    std::array<long, ELEMENT_COUNT> element_count{};
+    // elements matched by each path pattern, empty until the first start tag
+    std::vector<long> path_count;
+
+    // add the counts of other facts
+    Facts& operator+=(const Facts& other);
+
+    // counts for the unit report
+    UnitCounts unitCounts() const;
+
+    // save the counts in a checkpoint
+    void save(Checkpoint& checkpoint) const;
+
+    // restore the counts from a checkpoint
+    void restore(const Checkpoint& checkpoint);
+};
+
+// add the counts of other facts
+Facts& Facts::operator+=(const Facts& other) {
+
+    if (url.empty())
+        url = other.url;
+    total += other.total;
+    textsize += other.textsize;
+    loc += other.loc;
+    file_count += other.file_count;
+    for (int id = 0; id < ELEMENT_COUNT; ++id)
+        element_count[id] += other.element_count[id];
+    if (path_count.size() < other.path_count.size())
+        path_count.resize(other.path_count.size());
+    for (std::size_t pattern = 0; pattern < other.path_count.size(); ++pattern)
+        path_count[pattern] += other.path_count[pattern];
+
+    return *this;
+}
+
+// counts for the unit report
+UnitCounts Facts::unitCounts() const {
+
+    UnitCounts counts;
+    counts.loc = loc;
+    counts.characters = textsize;
+    counts.classes = element_count[ELEMENT_CLASS];
+    counts.functions = element_count[ELEMENT_FUNCTION];
+    counts.declarations = element_count[ELEMENT_DECL];
+    counts.expressions = element_count[ELEMENT_EXPR];
+    counts.comments = element_count[ELEMENT_COMMENT];
+    counts.returns = element_count[ELEMENT_RETURN];
+    counts.literals = element_count[ELEMENT_LITERAL];
+    counts.line_comments = element_count[ELEMENT_LINE_COMMENT];
+
+    return counts;
+}
+
+/*
+    Save the counts in a checkpoint. Element counts are saved by
+    element name, and only when not zero. Path counts are saved by
+    pattern, so a resume needs the same patterns.
+
+    @param checkpoint Checkpoint to add the counts to
+*/
+void Facts::save(Checkpoint& checkpoint) const {
+
+    checkpoint.values.emplace_back("url", url);
+    checkpoint.counters.emplace_back("files", file_count);
+    checkpoint.counters.emplace_back("loc", loc);
+    checkpoint.counters.emplace_back("characters", textsize);
+    for (int id = 0; id < ELEMENT_COUNT; ++id) {
+        if (element_count[id] != 0)
+            checkpoint.counters.emplace_back(std::string(SRCML_ELEMENT_NAMES[id]), element_count[id]);
+    }
+    for (std::size_t pattern = 0; pattern < path_count.size(); ++pattern)
+        checkpoint.counters.emplace_back("path:" + pathPatterns.pattern((int) pattern), path_count[pattern]);
+}
+
+/*
+    Restore the counts from a checkpoint.
+
+    @param checkpoint Checkpoint with the counts
+*/
+void Facts::restore(const Checkpoint& checkpoint) {
+
+    *this = Facts();
+    for (const auto& value : checkpoint.values) {
+        if (value.first == "url")
+            url = value.second;
+    }
+    file_count = checkpoint.counter("files");
+    loc = checkpoint.counter("loc");
+    textsize = checkpoint.counter("characters");
+    for (int id = 0; id < ELEMENT_COUNT; ++id)
+        element_count[id] = checkpoint.counter(SRCML_ELEMENT_NAMES[id]);
+    path_count.resize(pathPatterns.size());
+    for (int pattern = 0; pattern < pathPatterns.size(); ++pattern)
+        path_count[pattern] = checkpoint.counter("path:" + pathPatterns.pattern(pattern));
+}
+
+// counts between two points of the parse
+static UnitCounts operator-(const UnitCounts& end, const UnitCounts& start) {
+
+    UnitCounts counts;
+    counts.loc = end.loc - start.loc;
+    counts.characters = end.characters - start.characters;
+    counts.classes = end.classes - start.classes;
+    counts.functions = end.functions - start.functions;
+    counts.declarations = end.declarations - start.declarations;
+    counts.expressions = end.expressions - start.expressions;
+    counts.comments = end.comments - start.comments;
+    counts.returns = end.returns - start.returns;
+    counts.literals = end.literals - start.literals;
+    counts.line_comments = end.line_comments - start.line_comments;
+
+    return counts;
+}
+
+// parser with the srcFacts counts as handlers
+class srcFactsParser : public XMLParserBase<srcFactsParser> {
+public:
+
+    // constructor for standard input, with an optional batch for unit records
+    srcFactsParser(Facts& facts, bool asyncRead, UnitReport::Batch* units = nullptr)
+        : XMLParserBase(asyncRead), facts(facts), units(units)
+    {}
+
+    // constructor for an input source, e.g., an archive path, with an optional batch for unit records
+    srcFactsParser(Facts& facts, InputSource source, UnitReport::Batch* units = nullptr)
+        : XMLParserBase(std::move(source)), facts(facts), units(units)
+    {}
+
+    // constructor for part of a document already in memory, with an optional batch for unit records
+    srcFactsParser(Facts& facts, const char* begin, const char* end, int depth, UnitReport::Batch* units = nullptr)
+        : XMLParserBase(begin, end, depth), facts(facts), units(units)
+    {}
+
+    // constructor for standard input positioned at a checkpoint, restoring the counts
+    srcFactsParser(Facts& facts, const Checkpoint& checkpoint, bool asyncRead, UnitReport::Batch* units = nullptr)
+        : XMLParserBase(checkpoint, asyncRead), facts(facts), units(units), state(checkpoint)
+    {
+        facts.restore(checkpoint);
+        lastCheckpoint = checkpoint.offset;
+    }
+
+    /*
+        Save checkpoints at the start of file units, after at least
+        interval bytes of input since the last one, and at the end of
+        the root element.
+
+        @param path Path of the checkpoint file
+        @param interval Minimum bytes of input between checkpoints
+    */
+    void checkpointTo(const std::string& path, long interval) {
+
+        checkpointPath = path;
+        checkpointInterval = interval;
+    }
+
+    // start over with another archive, counted into the facts, which the caller clears
+    void reset(InputSource source) {
+
+        XMLParserBase::reset(std::move(source));
+        unitKey = std::string_view();
+        unitOpen = false;
+        inUnitTag = false;
+    }
+
+    // count elements by ID and by path pattern, and start the counts of a unit
+    void handleStartTag(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID /* ns */) {
+
+        if (!checkpointPath.empty()) {
+            // a file unit, or the root element, anchors the checkpoints after it
+            if (id == ELEMENT_UNIT && depth == 1 && tagOffset() - lastCheckpoint >= checkpointInterval)
+                saveCheckpoint();
+            if (depth == 0)
+                state.elements.assign(1, std::string(qname));
+            if (depth <= 1)
+                state.setAnchor(tagOffset(), tagText());
+        }
+        if (id == ELEMENT_UNIT) {
+            if (depth > 0)
+                ++facts.file_count;
+            if (units) {
+                unitStart = facts.unitCounts();
+                unitKey = std::string_view();
+                unitOpen = true;
+            }
+        } else if (id < ELEMENT_COUNT) {
+            ++facts.element_count[id];
+        }
+        inUnitTag = id == ELEMENT_UNIT;
+
+        if (!pathPatterns.empty()) {
+            if (facts.path_count.empty())
+                facts.path_count.resize(pathPatterns.size());
+            for (const int pattern : pathMatcher.open(depth, id))
+                ++facts.path_count[pattern];
+        }
+    }
+
+    // report a unit with no nested units
+    void handleEndTag(std::string_view /* qname */, std::string_view /* prefix */, std::string_view /* local_name */, ElementID id, NamespaceID /* ns */) {
+
+        if (id == ELEMENT_UNIT && unitOpen) {
+            units->add(unitKey, facts.unitCounts() - unitStart);
+            unitOpen = false;
+        }
+
+        // end of the root element, so appended units resume here
+        if (depth == 0 && !checkpointPath.empty())
+            saveCheckpoint();
+    }
+
+    // record the url of the archive, and the key of a unit
+    void handleAttribute(std::string_view /* qname */, std::string_view /* prefix */, std::string_view local_name, std::string_view value, NamespaceID /* ns */) {
+
+        if (local_name == "url")
+            facts.url = value;
+        if (inUnitTag && units) {
+            if (local_name == "filename" || (local_name == "url" && unitKey.empty()))
+                unitKey = keep(value);
+        }
+    }
+
+    // count lines and characters of text
+    void handleCharacters(std::string_view characters) {
+
+        countText(characters);
+    }
+
+    // count lines and characters of CDATA
+    void handleCDATA(std::string_view characters) {
+
+        countText(characters);
+    }
+
+    // count characters of entity references, which for a numeric reference may be a code point of several bytes
+    void handleEntityReference(std::string_view characters) {
+
+        facts.textsize += codePoints ? countCodePoints(characters.data(), characters.data() + characters.size()) : (long) characters.size();
+    }
+
+    // characters are counted as UTF-8 code points instead of bytes, set before any parse
+    static inline bool codePoints = false;
+
+private:
+    // count lines and characters of text in place, with the vectorized counts
+    void countText(std::string_view characters) {
+
+        const char* first = characters.data();
+        const char* last = first + characters.size();
+        facts.loc += countChar(first, last, '\n');
+        facts.textsize += codePoints ? countCodePoints(first, last) : (long) characters.size();
+    }
+
+    // save a checkpoint at the start of the current tag
+    void saveCheckpoint() {
+
+        Checkpoint checkpoint = tagCheckpoint();
+        checkpoint.elements = state.elements;
+        checkpoint.anchorOffset = state.anchorOffset;
+        checkpoint.anchorLength = state.anchorLength;
+        checkpoint.anchorHash = state.anchorHash;
+        facts.save(checkpoint);
+        // records of units before the checkpoint are not output again on resume
+        if (units)
+            units->flush();
+        if (!checkpoint.save(checkpointPath)) {
+            std::cerr << "srcFacts: Unable to write checkpoint " << checkpointPath << '\n';
+            exit(1);
+        }
+        lastCheckpoint = checkpoint.offset;
+    }
+
+    Facts& facts;
+    UnitReport::Batch* units;
+    // checkpoints, with the open root element and the anchor tag
+    std::string checkpointPath;
+    long checkpointInterval = 0;
+    long lastCheckpoint = 0;
+    Checkpoint state;
+    // counts at the start of the current unit
+    UnitCounts unitStart;
+    // key of the current unit, kept in the arena of the parser until the unit ends
+    std::string_view unitKey;
+    bool unitOpen = false;
+    bool inUnitTag = false;
+    // state of the path patterns for the open elements
+    PathPatterns::Matcher pathMatcher{ pathPatterns };
+};
+
+/*
+    Count the facts of a mapped srcML archive in parallel. The prolog
+    and root start tag are parsed first. The rest is split into one
+    range per file unit, parsed at depth 1 on the pool, and the
+    per-worker counts are merged.
+
+    @param begin Start of the document
+    @param end End of the document
+    @param threads Number of workers
+    @param facts Updated with the counts
+    @param report Report for unit records, or nullptr
+    @return false if the document is not split, e.g., there is no root start tag or no file units
+*/
+static bool parallelFacts(const char* begin, const char* end, int threads, Facts& facts, UnitReport* report) {
+
+    const char* rootEnd = findRootStartTagEnd(begin, end);
+    if (!rootEnd)
+        return false;
+
+    // ranges of the file units, from just after the root start tag to the end
+    WorkStealingPool pool(threads);
+    std::vector<const char*> bounds = findUnitStarts(rootEnd, end, pool);
+    if (bounds.empty())
+        return false;
+    bounds.insert(bounds.begin(), rootEnd);
+    bounds.push_back(end);
+
+    // prolog and root start tag
+    srcFactsParser rootParser(facts, begin, rootEnd, 0);
+    rootParser.parse();
+
+    std::vector<Facts> workerFacts(pool.size());
+    std::vector<std::unique_ptr<UnitReport::Batch>> workerUnits(pool.size());
+    if (report) {
+        for (auto& units : workerUnits)
+            units.reset(new UnitReport::Batch(*report));
+    }
+    pool.run(bounds.size() - 1, [&](std::size_t unit, int worker) {
+        srcFactsParser parser(workerFacts[worker], bounds[unit], bounds[unit + 1], 1, workerUnits[worker].get());
+        parser.inheritNamespaces(rootParser.namespaceNames());
+        parser.parse();
+    });
+    for (const auto& part : workerFacts)
+        facts += part;
+    facts.total = (long) std::distance(begin, end);
+
+    return true;
+}
+
+/*
+    Count the facts of the units of an archive selected with its index.
+    Only the prolog and root start tag, and the selected units, are
+    read. The input must be the size the index records. The units are
+    read with pread, checked against their hash, and parsed at depth 1
+    on the pool.
+
+    @param fd File descriptor of the archive, a regular file
+    @param index Index of the archive
+    @param patterns Filenames or globs of the units
+    @param threads Number of workers
+    @param facts Updated with the counts
+    @param report Report for unit records, or nullptr
+*/
+static void indexedFacts(int fd, const UnitIndex& index, const std::vector<std::string>& patterns, int threads, Facts& facts, UnitReport* report) {
+
+    // an index of another version of the archive has the wrong offsets
+    if (inputSize(fd) != (long) index.inputSize()) {
+        std::cerr << "srcFacts: Input does not match index\n";
+        exit(1);
+    }
+
+    // prolog and root start tag
+    std::string prolog((std::size_t) index.rootEnd(), '\0');
+    if (!readInputAt(fd, prolog.data(), (long) prolog.size(), 0)) {
+        std::cerr << "srcFacts: Input does not match index\n";
+        exit(1);
+    }
+    srcFactsParser rootParser(facts, prolog.data(), prolog.data() + prolog.size(), 0);
+    rootParser.parse();
+
+    const std::vector<UnitIndex::Entry> selected = index.select(patterns);
+    WorkStealingPool pool(threads);
+    std::vector<Facts> workerFacts(pool.size());
+    std::vector<std::string> workerBuffers(pool.size());
+    std::vector<std::unique_ptr<UnitReport::Batch>> workerUnits(pool.size());
+    if (report) {
+        for (auto& units : workerUnits)
+            units.reset(new UnitReport::Batch(*report));
+    }
+    pool.run(selected.size(), [&](std::size_t unit, int worker) {
+        const UnitIndex::Entry& entry = selected[unit];
+        std::string& buffer = workerBuffers[worker];
+        buffer.resize((std::size_t) entry.length);
+        if (!readInputAt(fd, buffer.data(), (long) entry.length, (long) entry.offset)
+            || UnitIndex::hash(buffer) != entry.hash) {
+            std::cerr << "srcFacts: Input does not match index\n";
+            exit(1);
+        }
+        srcFactsParser parser(workerFacts[worker], buffer.data(), buffer.data() + buffer.size(), 1, workerUnits[worker].get());
+        parser.inheritNamespaces(rootParser.namespaceNames());
+        parser.parse();
+    });
+
+    facts.total = (long) prolog.size();
+    for (const auto& part : workerFacts)
+        facts += part;
+    for (const auto& entry : selected)
+        facts.total += (long) entry.length;
+}
+
+/*
+    Count the facts of many archives. Each archive is parsed whole by
+    one worker of the pool, and they are started largest first, so a
+    large archive does not start last and keep one worker busy while
+    the rest are idle. A worker constructs its parser once, and resets
+    it for each of its archives, reusing its buffer and element names.
+
+    @param paths Paths of the archives
+    @param threads Number of workers
+    @param archiveFacts Set to the counts of each archive, in the order of the paths
+    @param report Report for unit records, or nullptr
+    @return false if an archive cannot be read
+*/
+static bool batchFacts(const std::vector<std::string>& paths, int threads, std::vector<Facts>& archiveFacts, UnitReport* report) {
+
+    // archives by decreasing size
+    std::vector<std::pair<std::uintmax_t, std::size_t>> bySize;
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        std::error_code error;
+        const std::uintmax_t size = std::filesystem::file_size(paths[i], error);
+        if (error || !InputSource::fromPath(paths[i]).isOpen()) {
+            std::cerr << "srcFacts: Unable to read " << paths[i] << '\n';
+            return false;
+        }
+        bySize.emplace_back(size, i);
+    }
+    std::stable_sort(bySize.begin(), bySize.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    WorkStealingPool pool(threads);
+    std::vector<Facts> workerFacts(pool.size());
+    std::vector<std::unique_ptr<srcFactsParser>> workerParsers(pool.size());
+    std::vector<std::unique_ptr<UnitReport::Batch>> workerUnits(pool.size());
+    if (report) {
+        for (auto& units : workerUnits)
+            units.reset(new UnitReport::Batch(*report));
+    }
+    archiveFacts.assign(paths.size(), Facts());
+    pool.run(bySize.size(), [&](std::size_t task, int worker) {
+        const std::size_t archive = bySize[task].second;
+        std::unique_ptr<srcFactsParser>& parser = workerParsers[worker];
+        workerFacts[worker] = Facts();
+        if (!parser)
+            parser.reset(new srcFactsParser(workerFacts[worker], InputSource::fromPath(paths[archive]), workerUnits[worker].get()));
+        else
+            parser->reset(InputSource::fromPath(paths[archive]));
+        parser->parse();
+        workerFacts[worker].total = parser->totalBytes();
+        archiveFacts[archive] = workerFacts[worker];
+    });
+
+    return true;
+}
+
+/*
+    Output the report of the facts.
+
+    @param title Title of the report, e.g., the url of the archive
+    @param facts Counts of the report
+*/
+static void outputReport(const std::string& title, const Facts& facts) {
+
+    std::cout << "# srcFacts: " << title <<'\n';
     std::cout << "| Item | Count |\n";
     std::cout << "|:-----|-----:|\n";
-    std::cout << "| srcML | " << total << " |\n";
-    std::cout << "| files | " << file_count << " |\n";
-    std::cout << "| LOC | " << loc << " |\n";
-    std::cout << "| characters | " << textsize << " |\n";
-    std::cout << "| classes | " << class_count << " |\n";
-    std::cout << "| functions | " << function_count << " |\n";
-    std::cout << "| declarations | " << decl_count << " |\n";
-    std::cout << "| expressions | " << expr_count << " |\n";
-    std::cout << "| comments | " << comment_count << " |\n";
-    std::cout << "| returns | " << return_count << " |\n";
-    std::cout << "| literal strings | " << literal_string_count << " |\n";
-    std::cout << "| line comments | " << line_comment_count << " |\n";
+    std::cout << "| srcML | " << facts.total << " |\n";
+    std::cout << "| files | " << facts.file_count << " |\n";
+    std::cout << "| LOC | " << facts.loc << " |\n";
+    std::cout << "| characters | " << facts.textsize << " |\n";
+    std::cout << "| classes | " << facts.element_count[ELEMENT_CLASS] << " |\n";
+    std::cout << "| functions | " << facts.element_count[ELEMENT_FUNCTION] << " |\n";
+    std::cout << "| declarations | " << facts.element_count[ELEMENT_DECL] << " |\n";
+    std::cout << "| expressions | " << facts.element_count[ELEMENT_EXPR] << " |\n";
+    std::cout << "| comments | " << facts.element_count[ELEMENT_COMMENT] << " |\n";
+    std::cout << "| returns | " << facts.element_count[ELEMENT_RETURN] << " |\n";
+    std::cout << "| literal strings | " << facts.element_count[ELEMENT_LITERAL] << " |\n";
+    std::cout << "| line comments | " << facts.element_count[ELEMENT_LINE_COMMENT] << " |\n";
+    for (int pattern = 0; pattern < pathPatterns.size(); ++pattern)
+        std::cout << "| " << pathPatterns.pattern(pattern) << " | " << (pattern < (int) facts.path_count.size() ? facts.path_count[pattern] : 0) << " |\n";
+}
+
+int main(int argc, char* argv[]) {
+
+    int threads = 1;
+    bool asyncRead = false;
+    std::unique_ptr<UnitReport> report;
+    std::string checkpointPath;
+    long checkpointInterval = 64 * 1024 * 1024;
+    std::string resumePath;
+    std::string buildIndexPath;
+    std::string indexPath;
+    std::vector<std::string> patterns;
+    std::vector<std::string> paths;
+    bool batch = false;
+    for (int i = 1; i < argc; ++i) {
+        if ((std::strcmp(argv[i], "-j") == 0 || std::strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--async") == 0) {
+            asyncRead = true;
+        } else if (std::strcmp(argv[i], "--units") == 0 && i + 1 < argc) {
+            UnitReport::Format format;
+            if (!UnitReport::parseFormat(argv[++i], format)) {
+                std::cerr << "srcFacts: unknown unit report format " << argv[i] << '\n';
+                return 1;
+            }
+            report.reset(new UnitReport(format));
+        } else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            checkpointPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc) {
+            checkpointInterval = (long) (std::atof(argv[++i]) * 1024 * 1024);
+        } else if (std::strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+            resumePath = argv[++i];
+        } else if (std::strcmp(argv[i], "--build-index") == 0 && i + 1 < argc) {
+            buildIndexPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--index") == 0 && i + 1 < argc) {
+            indexPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--select") == 0 && i + 1 < argc) {
+            patterns.push_back(argv[++i]);
+        } else if (std::strcmp(argv[i], "--batch") == 0) {
+            batch = true;
+        } else if (std::strcmp(argv[i], "--code-points") == 0) {
+            srcFactsParser::codePoints = true;
+        } else if (std::strcmp(argv[i], "--paths") == 0 && i + 1 < argc) {
+            if (!pathPatterns.load(argv[++i])) {
+                std::cerr << "srcFacts: Invalid path patterns " << argv[i] << '\n';
+                return 1;
+            }
+        } else if (argv[i][0] != '-') {
+            paths.push_back(argv[i]);
+        } else {
+            std::cerr << "usage: srcFacts [-j threads] [--async] [--code-points] [--paths file] [--units ndjson|csv]"
+                         " [--checkpoint file [--checkpoint-every MB]] [--resume file] < project.xml\n"
+                         "       srcFacts [-j threads] --build-index project.idx < project.xml\n"
+                         "       srcFacts [-j threads] [--units ndjson|csv] --index project.idx --select pattern... < project.xml\n"
+                         "       srcFacts [-j threads] [--units ndjson|csv] project.xml... | --batch < paths.txt\n";
+            return 1;
+        }
+    }
+
+    // many archives, each with a report, and then the total
+    if (batch || !paths.empty()) {
+        if (!checkpointPath.empty() || !resumePath.empty() || !buildIndexPath.empty() || !indexPath.empty()) {
+            std::cerr << "srcFacts: Archive paths are not for checkpoints or indexes\n";
+            return 1;
+        }
+        if (batch) {
+            std::string path;
+            while (std::getline(std::cin, path)) {
+                if (!path.empty())
+                    paths.push_back(path);
+            }
+        }
+        std::vector<Facts> archiveFacts;
+        if (!batchFacts(paths, threads, archiveFacts, report.get()))
+            return 1;
+        if (report)
+            return 0;
+
+        Facts total;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            outputReport(paths[i] + (archiveFacts[i].url.empty() ? "" : " " + archiveFacts[i].url), archiveFacts[i]);
+            std::cout << '\n';
+            total += archiveFacts[i];
+        }
+        outputReport("total of " + std::to_string(paths.size()) + " archives", total);
+
+        return 0;
+    }
 
+    if (!indexPath.empty() && patterns.empty()) {
+        std::cerr << "srcFacts: --index needs at least one --select pattern\n";
+        return 1;
+    }
+
+    // index of the units of the archive
+    if (!buildIndexPath.empty()) {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        if (!mapInput(0, begin, end) || Decompressor::format(begin, end) != Decompressor::NONE) {
+            std::cerr << "srcFacts: Indexed input must be an uncompressed regular file\n";
+            return 1;
+        }
+        WorkStealingPool pool(threads);
+        UnitIndex index;
+        const bool built = index.build(begin, end, pool);
+        unmapInput(begin, end);
+        if (!built) {
+            std::cerr << "srcFacts: Input is not a srcML archive\n";
+            return 1;
+        }
+        if (!index.save(buildIndexPath)) {
+            std::cerr << "srcFacts: Unable to write index " << buildIndexPath << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    // checkpoints are taken by a serial parse
+    if (!checkpointPath.empty() || !resumePath.empty())
+        threads = 1;
+
+    Checkpoint checkpoint;
+    if (!resumePath.empty()) {
+        if (!checkpoint.load(resumePath)) {
+            std::cerr << "srcFacts: Invalid checkpoint " << resumePath << '\n';
+            return 1;
+        }
+        if (!checkpoint.seekInput(0)) {
+            std::cerr << "srcFacts: Input does not match checkpoint " << resumePath << '\n';
+            return 1;
+        }
+    }
+
+    Facts facts;
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    if (!indexPath.empty()) {
+        UnitIndex index;
+        if (!index.load(indexPath)) {
+            std::cerr << "srcFacts: Invalid index " << indexPath << '\n';
+            return 1;
+        }
+        indexedFacts(0, index, patterns, threads, facts, report.get());
+    } else if (threads > 1 && mapInput(0, begin, end) && Decompressor::format(begin, end) == Decompressor::NONE) {
+        // compressed input is decompressed as a stream, so only uncompressed input is split
+        if (!parallelFacts(begin, end, threads, facts, report.get())) {
+            facts = Facts();
+            std::unique_ptr<UnitReport::Batch> units(report ? new UnitReport::Batch(*report) : nullptr);
+            srcFactsParser parser(facts, begin, end, 0, units.get());
+            parser.parse();
+            facts.total = parser.totalBytes();
+        }
+        unmapInput(begin, end);
+    } else if (!resumePath.empty()) {
+        std::unique_ptr<UnitReport::Batch> units(report ? new UnitReport::Batch(*report) : nullptr);
+        srcFactsParser parser(facts, checkpoint, asyncRead, units.get());
+        if (!checkpointPath.empty())
+            parser.checkpointTo(checkpointPath, checkpointInterval);
+        parser.parse();
+        facts.total = checkpoint.offset + parser.totalBytes();
+    } else {
+        if (begin)
+            unmapInput(begin, end);
+        std::unique_ptr<UnitReport::Batch> units(report ? new UnitReport::Batch(*report) : nullptr);
+        srcFactsParser parser(facts, asyncRead, units.get());
+        if (!checkpointPath.empty())
+            parser.checkpointTo(checkpointPath, checkpointInterval);
+        parser.parse();
+        facts.total = parser.totalBytes();
+    }
+
+    // the unit records are the report
+    if (report)
+        return 0;
+
+    // output the report
+    outputReport(facts.url, facts);
     return 0;
 }
@@ -0,0 +1,210 @@
+/*
+    srcMLElements.hpp
+
+    IDs of the srcML element names, with a compile-time perfect hash
+
+    Each element local name in the srcML vocabulary has a fixed small
+    integer ID, ELEMENT_<NAME>. IDs are for local names, so, e.g.,
+    cpp:if and if have the same ID. knownElementID() maps a name to
+    its ID with one hash, one table lookup, and one comparison. The
+    hash seed is searched for at compile time so that no two names
+    in the vocabulary share a slot.
+ */
+
+#ifndef INCLUDE_SRCMLELEMENTS_HPP
+#define INCLUDE_SRCMLELEMENTS_HPP
+
+#include "fnvHash.hpp"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// srcML vocabulary as X(ID, "local name")
+#define SRCML_ELEMENTS(X) \
+    X(UNIT, "unit") \
+    X(EXPR, "expr") \
+    X(FUNCTION, "function") \
+    X(DECL, "decl") \
+    X(CLASS, "class") \
+    X(COMMENT, "comment") \
+    X(RETURN, "return") \
+    X(LITERAL, "literal") \
+    X(LINE_COMMENT, "line_comment") \
+    X(NAME, "name") \
+    X(TYPE, "type") \
+    X(SPECIFIER, "specifier") \
+    X(DECL_STMT, "decl_stmt") \
+    X(INIT, "init") \
+    X(EXPR_STMT, "expr_stmt") \
+    X(CALL, "call") \
+    X(ARGUMENT_LIST, "argument_list") \
+    X(ARGUMENT, "argument") \
+    X(PARAMETER_LIST, "parameter_list") \
+    X(PARAMETER, "parameter") \
+    X(FUNCTION_DECL, "function_decl") \
+    X(CONSTRUCTOR, "constructor") \
+    X(CONSTRUCTOR_DECL, "constructor_decl") \
+    X(DESTRUCTOR, "destructor") \
+    X(DESTRUCTOR_DECL, "destructor_decl") \
+    X(BLOCK, "block") \
+    X(BLOCK_CONTENT, "block_content") \
+    X(IF_STMT, "if_stmt") \
+    X(IF, "if") \
+    X(ELSE, "else") \
+    X(ELSEIF, "elseif") \
+    X(THEN, "then") \
+    X(CONDITION, "condition") \
+    X(WHILE, "while") \
+    X(FOR, "for") \
+    X(FOREACH, "foreach") \
+    X(CONTROL, "control") \
+    X(INCR, "incr") \
+    X(DO, "do") \
+    X(SWITCH, "switch") \
+    X(CASE, "case") \
+    X(DEFAULT, "default") \
+    X(BREAK, "break") \
+    X(CONTINUE, "continue") \
+    X(GOTO, "goto") \
+    X(LABEL, "label") \
+    X(TYPEDEF, "typedef") \
+    X(STRUCT, "struct") \
+    X(STRUCT_DECL, "struct_decl") \
+    X(UNION, "union") \
+    X(UNION_DECL, "union_decl") \
+    X(CLASS_DECL, "class_decl") \
+    X(ENUM, "enum") \
+    X(ENUM_DECL, "enum_decl") \
+    X(PUBLIC, "public") \
+    X(PRIVATE, "private") \
+    X(PROTECTED, "protected") \
+    X(SUPER_LIST, "super_list") \
+    X(SUPER, "super") \
+    X(MEMBER_INIT_LIST, "member_init_list") \
+    X(OPERATOR, "operator") \
+    X(MODIFIER, "modifier") \
+    X(INDEX, "index") \
+    X(SIZEOF, "sizeof") \
+    X(ALIGNOF, "alignof") \
+    X(ALIGNAS, "alignas") \
+    X(TYPEID, "typeid") \
+    X(DECLTYPE, "decltype") \
+    X(NOEXCEPT, "noexcept") \
+    X(ASM, "asm") \
+    X(MACRO, "macro") \
+    X(EXTERN, "extern") \
+    X(NAMESPACE, "namespace") \
+    X(USING, "using") \
+    X(TEMPLATE, "template") \
+    X(TYPENAME, "typename") \
+    X(LAMBDA, "lambda") \
+    X(CAPTURE, "capture") \
+    X(TRY, "try") \
+    X(CATCH, "catch") \
+    X(FINALLY, "finally") \
+    X(THROW, "throw") \
+    X(THROWS, "throws") \
+    X(TERNARY, "ternary") \
+    X(RANGE, "range") \
+    X(CAST, "cast") \
+    X(FRIEND, "friend") \
+    X(ATTRIBUTE, "attribute") \
+    X(ANNOTATION, "annotation") \
+    X(IMPORT, "import") \
+    X(PACKAGE, "package") \
+    X(INTERFACE, "interface") \
+    X(INTERFACE_DECL, "interface_decl") \
+    X(EMPTY_STMT, "empty_stmt") \
+    X(ESCAPE, "escape") \
+    X(MODULE, "module") \
+    X(POSITION, "position") \
+    X(DEFINE, "define") \
+    X(DIRECTIVE, "directive") \
+    X(INCLUDE, "include") \
+    X(FILE, "file") \
+    X(IFDEF, "ifdef") \
+    X(IFNDEF, "ifndef") \
+    X(ELIF, "elif") \
+    X(ENDIF, "endif") \
+    X(UNDEF, "undef") \
+    X(PRAGMA, "pragma") \
+    X(ERROR, "error") \
+    X(WARNING, "warning") \
+    X(LINE, "line") \
+    X(VALUE, "value") \
+    X(EMPTY, "empty") \
+    X(NUMBER, "number")
+
+// element ID, from the vocabulary or interned at run time
+enum ElementID : int {
+#define SRCML_ELEMENT_ID(ID, NAME) ELEMENT_##ID,
+    SRCML_ELEMENTS(SRCML_ELEMENT_ID)
+#undef SRCML_ELEMENT_ID
+    // number of IDs in the srcML vocabulary, and the first interned ID
+    ELEMENT_COUNT
+};
+
+// local names of the srcML vocabulary, indexed by ID
+constexpr std::string_view SRCML_ELEMENT_NAMES[] = {
+#define SRCML_ELEMENT_NAME(ID, NAME) NAME,
+    SRCML_ELEMENTS(SRCML_ELEMENT_NAME)
+#undef SRCML_ELEMENT_NAME
+};
+
+namespace srcMLElementHash {
+
+    // table size, a power of two
+    constexpr std::uint32_t SLOTS = 2048;
+
+    // first seed with no two vocabulary names in the same slot
+    constexpr std::uint32_t findSeed() {
+
+        for (std::uint32_t seed = 0; seed < 100000; ++seed) {
+            std::array<bool, SLOTS> used{};
+            bool collision = false;
+            for (auto name : SRCML_ELEMENT_NAMES) {
+                const std::uint32_t slot = fnvHash32(name, seed) & (SLOTS - 1);
+                if (used[slot]) {
+                    collision = true;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (!collision)
+                return seed;
+        }
+        return ~0u;
+    }
+
+    constexpr std::uint32_t SEED = findSeed();
+    static_assert(SEED != ~0u, "no perfect hash seed for the srcML vocabulary");
+
+    // slot to ID + 1, with 0 for an empty slot
+    constexpr std::array<std::uint8_t, SLOTS> makeTable() {
+
+        std::array<std::uint8_t, SLOTS> table{};
+        for (int id = 0; id < ELEMENT_COUNT; ++id)
+            table[fnvHash32(SRCML_ELEMENT_NAMES[id], SEED) & (SLOTS - 1)] = (std::uint8_t) (id + 1);
+        return table;
+    }
+
+    constexpr std::array<std::uint8_t, SLOTS> TABLE = makeTable();
+    static_assert(ELEMENT_COUNT < 255, "srcML vocabulary too large for the hash table entries");
+}
+
+/*
+    ID of a srcML element local name.
+
+    @param local_name Element local name
+    @return ID of the name, or -1 if it is not in the srcML vocabulary
+*/
+inline int knownElementID(std::string_view local_name) {
+
+    const int entry = srcMLElementHash::TABLE[fnvHash32(local_name, srcMLElementHash::SEED) & (srcMLElementHash::SLOTS - 1)];
+    if (entry == 0 || SRCML_ELEMENT_NAMES[entry - 1] != local_name)
+        return -1;
+
+    return entry - 1;
+}
+
+#endif
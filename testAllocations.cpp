@@ -0,0 +1,198 @@
+/*
+    testAllocations.cpp
+
+    Test that the parse does no heap allocation per event
+
+    Heap allocations are counted by replacing the global operator new.
+    A generated srcML archive, with every kind of part, is parsed
+    through XMLParserBase twice with the same parser. The first parse
+    is the setup: it sizes the buffer, interns element names not in
+    the srcML vocabulary, and grows the arena of kept values. After a
+    reset(), the second parse must not allocate at all.
+
+    The archive is parsed both in memory, in place, and from a
+    callback with small reads, so that the buffer is refilled in the
+    middle of tags, text, and entity references.
+
+    Usage: testAllocations
+
+    Returns 0 if the second parse did not allocate, and 1 if it did.
+*/
+
+#include "XMLParserBase.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+// heap allocations so far
+static long allocations = 0;
+
+void* operator new(std::size_t size) {
+
+    ++allocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+
+    std::free(p);
+}
+
+// parser with a handler for every part, keeping the filename of each unit
+class AllocationParser : public XMLParserBase<AllocationParser> {
+public:
+    using XMLParserBase::XMLParserBase;
+
+    void handleDeclaration(std::string_view /* target */) { ++events; }
+    void handleRequiredVersion(std::string_view /* version */) { ++events; }
+    void handleEncoding(std::string_view /* encoding */) { ++events; }
+    void handleStandalone(std::string_view /* standalone */) { ++events; }
+
+    void handleStartTag(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, ElementID /* id */, NamespaceID /* ns */) {
+
+        ++events;
+        bytes += (long) qname.size();
+    }
+
+    void handleEndTag(std::string_view qname, std::string_view /* prefix */, std::string_view /* local_name */, ElementID /* id */, NamespaceID /* ns */) {
+
+        ++events;
+        bytes += (long) qname.size();
+    }
+
+    void handleNameSpace(std::string_view /* prefix */, std::string_view uri) {
+
+        ++events;
+        bytes += (long) uri.size();
+    }
+
+    void handleAttribute(std::string_view /* qname */, std::string_view /* prefix */, std::string_view local_name, std::string_view value, NamespaceID /* ns */) {
+
+        ++events;
+        bytes += (long) value.size();
+        if (local_name == "filename")
+            filename = keep(value);
+    }
+
+    void handleCDATAChunk(std::string_view characters, int /* flags */) {
+
+        ++events;
+        bytes += (long) characters.size();
+    }
+
+    void handleCommentChunk(std::string_view comment, int /* flags */) {
+
+        ++events;
+        bytes += (long) comment.size();
+    }
+
+    void handleEntityReference(std::string_view characters) {
+
+        ++events;
+        bytes += (long) characters.size();
+    }
+
+    void handleCharacters(std::string_view characters) {
+
+        ++events;
+        bytes += (long) characters.size();
+    }
+
+    long events = 0;
+    long bytes = 0;
+    std::string_view filename;
+};
+
+// srcML archive with every kind of part, and element names not in the srcML vocabulary
+static std::string generateArchive() {
+
+    std::string archive = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+                          "<unit xmlns=\"http://www.srcML.org/srcML/src\" xmlns:cpp=\"http://www.srcML.org/srcML/cpp\""
+                          " revision=\"1.0.0\" url=\"test\">\n";
+    for (int i = 0; i < 20000; ++i) {
+        archive += "<unit revision=\"1.0.0\" language=\"C++\" filename=\"src/file" + std::to_string(i) + ".cpp\">";
+        archive += "<cpp:include>#<cpp:directive>include</cpp:directive> <cpp:file>&lt;vector&gt;</cpp:file></cpp:include>\n";
+        archive += "<comment type=\"block\">/* a comment with &amp; and &#x263A; */</comment>\n";
+        archive += "<function><type><name>int</name></type> <name>f</name><parameter_list>(<parameter><decl><type><name>int</name></type> <name>n</name></decl></parameter>)</parameter_list>"
+                   " <block>{<block_content>\n"
+                   "    <if_stmt><if>if <condition>(<expr><name>n</name> <operator>&lt;</operator> <literal type=\"number\">3</literal></expr>)</condition>"
+                   "<block type=\"pseudo\"><block_content> <return>return <expr><literal type=\"number\">1</literal></expr>;</return></block_content></block></if></if_stmt>\n"
+                   "    <extension_element attribute=\"value\"/><empty/>\n"
+                   "    <!-- an XML comment --><![CDATA[ <not> & markup ]]>\n"
+                   "    <return>return <expr><name>n</name> <operator>&amp;&amp;</operator> <literal type=\"char\">'&#65;'</literal></expr>;</return>\n"
+                   "</block_content>}</block></function>\n";
+        archive += "</unit>\n";
+    }
+    archive += "</unit>\n";
+
+    return archive;
+}
+
+/*
+    Parse twice, the second time after a reset() to the same input,
+    and report allocations during the second parse.
+
+    @param what Name of the input mode
+    @param source Source of the input for a parse
+    @return true if the second parse did not allocate, and matches the first
+*/
+template <class MakeSource>
+static bool parseTwice(const char* what, MakeSource source) {
+
+    // setup, and a first parse that sizes the buffer, names, and arena
+    AllocationParser parser(source());
+    parser.parse();
+    const long events = parser.events;
+    const long bytes = parser.bytes;
+
+    parser.events = 0;
+    parser.bytes = 0;
+    parser.reset(source());
+    const long startAllocations = allocations;
+    parser.parse();
+    const long parseAllocations = allocations - startAllocations;
+
+    if (parseAllocations != 0) {
+        std::cerr << "testAllocations: " << parseAllocations << " allocations in a parse " << what << '\n';
+        return false;
+    }
+    if (parser.events != events || parser.bytes != bytes || events == 0) {
+        std::cerr << "testAllocations: parses " << what << " differ\n";
+        return false;
+    }
+    std::cout << "testAllocations: no allocations in a parse " << what << " of " << events << " parts\n";
+
+    return true;
+}
+
+int main() {
+
+    const std::string archive = generateArchive();
+
+    const bool inMemory = parseTwice("in memory", [&]() { return InputSource::fromMemory(archive); });
+
+    std::size_t offset = 0;
+    const bool fromCallback = parseTwice("from a callback", [&]() {
+        offset = 0;
+        return InputSource::fromCallback([&](char* data, long size) {
+            // reads that are small and uneven, so refills cut every kind of part
+            const long available = (long) (archive.size() - offset);
+            const long count = std::min({ size, available, 4093L });
+            std::memcpy(data, archive.data() + offset, (std::size_t) count);
+            offset += (std::size_t) count;
+            return count;
+        });
+    });
+
+    return inMemory && fromCallback ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/*
+    testScanDelimiters.cpp
+
+    Differential test of the scanning kernel against plain loops
+
+    The kernel is selected as in the parsers, so it is forced with
+    SRCFACTS_SCAN=scalar|sse2|avx2|avx512, and ctest runs this once
+    for each. The scans and counts are compared with plain loops on
+    random buffers, at every length and alignment around the vector
+    widths, and on long buffers past the 255-block counts of SSE2.
+    Delimiters and UTF-8 bytes are frequent, so that masks with many,
+    one, and no matches are all tested.
+
+    Usage: SRCFACTS_SCAN=avx2 testScanDelimiters
+
+    Returns 0 if all match, 1 on a mismatch, and 77, a skip for
+    ctest, if the forced kernel is not supported by the CPU.
+*/
+
+#include "scanDelimiters.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+// first c1 or c2, or last
+const char* referenceScanChars(const char* first, const char* last, char c1, char c2) {
+
+    for (; first != last; ++first) {
+        if (*first == c1 || *first == c2)
+            return first;
+    }
+    return last;
+}
+
+// first whitespace, '>', or '/', or last
+const char* referenceScanNameEnd(const char* first, const char* last) {
+
+    for (; first != last; ++first) {
+        const char c = *first;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r' || c == '>' || c == '/')
+            return first;
+    }
+    return last;
+}
+
+// number of c
+long referenceCountChar(const char* first, const char* last, char c) {
+
+    long count = 0;
+    for (; first != last; ++first) {
+        if (*first == c)
+            ++count;
+    }
+    return count;
+}
+
+// number of bytes that are not UTF-8 continuation bytes
+long referenceCountCodePoints(const char* first, const char* last) {
+
+    long count = 0;
+    for (; first != last; ++first) {
+        const unsigned char c = (unsigned char) *first;
+        if (c < 0x80 || c > 0xBF)
+            ++count;
+    }
+    return count;
+}
+
+// random text, with one byte in density of the delimiters and UTF-8 bytes
+std::string randomText(std::mt19937& random, std::size_t size, int density) {
+
+    static const char special[] = { '<', '&', '>', '/', ' ', '\t', '\n', '\r', '\v', '\f', ';',
+                                    (char) 0x80, (char) 0xBF, (char) 0xC0, (char) 0xE2, (char) 0xFF, (char) 0x7F };
+    std::string text(size, 'a');
+    for (auto& c : text) {
+        if ((int) (random() % density) == 0)
+            c = special[random() % sizeof(special)];
+        else
+            c = (char) ('a' + random() % 26);
+    }
+    return text;
+}
+
+// compare all the scans and counts on [first, last), reporting a mismatch
+bool check(const char* first, const char* last, const char* what) {
+
+    bool same = true;
+    if (scanChars(first, last, '<', '&') != referenceScanChars(first, last, '<', '&')) {
+        std::cerr << "testScanDelimiters: scanChars differs on " << what << '\n';
+        same = false;
+    }
+    if (scanChar(first, last, '>') != referenceScanChars(first, last, '>', '>')) {
+        std::cerr << "testScanDelimiters: scanChar differs on " << what << '\n';
+        same = false;
+    }
+    if (scanNameEnd(first, last) != referenceScanNameEnd(first, last)) {
+        std::cerr << "testScanDelimiters: scanNameEnd differs on " << what << '\n';
+        same = false;
+    }
+    if (countChar(first, last, '\n') != referenceCountChar(first, last, '\n')) {
+        std::cerr << "testScanDelimiters: countChar differs on " << what << '\n';
+        same = false;
+    }
+    if (countCodePoints(first, last) != referenceCountCodePoints(first, last)) {
+        std::cerr << "testScanDelimiters: countCodePoints differs on " << what << '\n';
+        same = false;
+    }
+    return same;
+}
+
+}
+
+int main() {
+
+    // a forced kernel the CPU does not have falls back to another, so the test is skipped
+    const char* forced = std::getenv("SRCFACTS_SCAN");
+    if (forced && std::strcmp(forced, scanKernel()) != 0) {
+        std::cout << "testScanDelimiters: " << forced << " not supported, " << scanKernel() << " selected\n";
+        return 77;
+    }
+
+    std::mt19937 random(20261018);
+
+    // every length and alignment around the vector widths, with dense, sparse, and no delimiters
+    for (const int density : { 2, 7, 40, 1000000 }) {
+        const std::string text = randomText(random, 512, density);
+        for (std::size_t offset = 0; offset < 64; ++offset) {
+            for (std::size_t length = 0; length <= 200 && offset + length <= text.size(); ++length) {
+                const std::string what = "offset " + std::to_string(offset) + " length " + std::to_string(length)
+                                       + " density " + std::to_string(density);
+                if (!check(text.data() + offset, text.data() + offset + length, what.c_str()))
+                    return 1;
+            }
+        }
+    }
+
+    // a match only in the last byte, for each length
+    for (std::size_t length = 1; length <= 200; ++length) {
+        for (const char c : { '<', '&', '>', '/', ' ', '\n', (char) 0x80 }) {
+            std::string text(length, 'x');
+            text.back() = c;
+            const std::string what = "last byte of length " + std::to_string(length);
+            if (!check(text.data(), text.data() + text.size(), what.c_str()))
+                return 1;
+        }
+    }
+
+    // long ranges, past the 255 blocks of the SSE2 counters, with all newlines or continuation bytes
+    for (const char c : { '\n', (char) 0x80, 'a' }) {
+        const std::string text(255 * 16 * 3 + 37, c);
+        if (!check(text.data(), text.data() + text.size(), "a run of one byte"))
+            return 1;
+    }
+    for (int trial = 0; trial < 200; ++trial) {
+        const std::string text = randomText(random, 1 + random() % 100000, 1 + random() % 50);
+        const std::size_t offset = random() % 64 % text.size();
+        if (!check(text.data() + offset, text.data() + text.size(), "a random long range"))
+            return 1;
+    }
+
+    std::cout << "testScanDelimiters: " << scanKernel() << " matches\n";
+
+    return 0;
+}
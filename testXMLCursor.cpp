@@ -0,0 +1,132 @@
+/*
+    testXMLCursor.cpp
+
+    Test that XMLCursor passes a CDATA section or comment larger than
+    the buffer as one token for each chunk
+
+    A document with a comment and a CDATA section of several buffers
+    is written to a pipe on another thread, and read by the cursor
+    from the pipe, so the buffer is refilled inside both. Each chunk
+    is checked against the document when next() returns it, before
+    the next call may refill the buffer. The same document in memory
+    is one token for each.
+
+    Usage: testXMLCursor
+
+    Returns 0 if the tokens match the document, and 1 if they do not.
+*/
+
+#include "XMLCursor.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+// content of several buffers, with partial delimiters throughout
+std::string largeContent(std::string_view line) {
+
+    std::string content;
+    while (content.size() < 3 * (std::size_t) BUFFER_SIZE)
+        content.append(line.data(), line.size());
+
+    return content;
+}
+
+/*
+    Read the document with the cursor, and check the comment and CDATA.
+
+    @param cursor Cursor over the document
+    @param comment Content of the comment
+    @param cdata Content of the CDATA section
+    @param what Name of the input mode
+    @param chunks Set to the number of comment and CDATA tokens
+    @return true if the tokens match the document
+*/
+bool checkTokens(XMLCursor& cursor, const std::string& comment, const std::string& cdata, const char* what, int& chunks) {
+
+    std::size_t commentOffset = 0;
+    std::size_t cdataOffset = 0;
+    bool end = false;
+    chunks = 0;
+    for (auto token = &cursor.next(); token->kind != XMLToken::END_OF_INPUT; token = &cursor.next()) {
+        if (token->kind == XMLToken::COMMENT) {
+            ++chunks;
+            if (comment.compare(commentOffset, token->value.size(), token->value) != 0) {
+                std::cerr << "testXMLCursor: comment chunk at " << commentOffset << " differs " << what << '\n';
+                return false;
+            }
+            commentOffset += token->value.size();
+        } else if (token->kind == XMLToken::CDATA) {
+            ++chunks;
+            if (cdata.compare(cdataOffset, token->value.size(), token->value) != 0) {
+                std::cerr << "testXMLCursor: CDATA chunk at " << cdataOffset << " differs " << what << '\n';
+                return false;
+            }
+            cdataOffset += token->value.size();
+        } else if (token->kind == XMLToken::END_TAG && token->name == "a") {
+            end = true;
+        }
+    }
+    if (commentOffset != comment.size() || cdataOffset != cdata.size() || !end) {
+        std::cerr << "testXMLCursor: parts of the document are missing " << what << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+}
+
+int main() {
+
+    const std::string comment = largeContent(" a comment - with dashes -\n");
+    const std::string cdata = largeContent(" <not> & markup ]] or ] \n");
+    const std::string document = "<unit><!--" + comment + "--><![CDATA[" + cdata + "]]><a x=\"1\">text</a></unit>\n";
+
+    // from a pipe, so the buffer is refilled inside the comment and the CDATA
+    int fds[2];
+    if (pipe(fds) == -1) {
+        std::cerr << "testXMLCursor: Unable to create a pipe\n";
+        return 1;
+    }
+    std::thread writer([&]() {
+        const char* data = document.data();
+        std::size_t size = document.size();
+        while (size > 0) {
+            const ssize_t numbytes = write(fds[1], data, size);
+            if (numbytes <= 0)
+                break;
+            data += numbytes;
+            size -= (std::size_t) numbytes;
+        }
+        close(fds[1]);
+    });
+    int pipeChunks = 0;
+    bool fromPipe = false;
+    {
+        XMLCursor cursor(InputSource::fromFD(fds[0]));
+        fromPipe = checkTokens(cursor, comment, cdata, "from a pipe", pipeChunks);
+    }
+    writer.join();
+    close(fds[0]);
+    if (fromPipe && pipeChunks <= 2) {
+        std::cerr << "testXMLCursor: " << pipeChunks << " chunks from a pipe\n";
+        fromPipe = false;
+    }
+
+    // in memory, each is one token
+    int memoryChunks = 0;
+    XMLCursor cursor(document.data(), document.data() + document.size());
+    bool inMemory = checkTokens(cursor, comment, cdata, "in memory", memoryChunks);
+    if (inMemory && memoryChunks != 2) {
+        std::cerr << "testXMLCursor: " << memoryChunks << " chunks in memory\n";
+        inMemory = false;
+    }
+
+    if (fromPipe && inMemory)
+        std::cout << "testXMLCursor: " << pipeChunks << " chunks from a pipe, and whole in memory\n";
+
+    return fromPipe && inMemory ? 0 : 1;
+}
@@ -6,14 +6,55 @@
 
 #include "xml_parser.hpp"
 #include "refillBuffer.hpp"
+#include "scanDelimiters.hpp"
+#include "decodeEntities.hpp"
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <cstring>
 #include <string>
 
 const int XMLNS_SIZE = strlen("xmlns");
-const int BUFFER_SIZE = 16 * 16 * 4096;
-std::string buffer(BUFFER_SIZE, ' ');
+
+// vectorized scan for c over buffer iterators
+static std::string::const_iterator scanChar(std::string::const_iterator first, std::string::const_iterator last, char c) {
+
+    if (first == last)
+        return last;
+    const char* pfirst = &*first;
+
+    return std::next(first, ::scanChar(pfirst, std::next(pfirst, std::distance(first, last)), c) - pfirst);
+}
+
+// vectorized scan for c1 or c2 over buffer iterators
+static std::string::const_iterator scanChars(std::string::const_iterator first, std::string::const_iterator last, char c1, char c2) {
+
+    if (first == last)
+        return last;
+    const char* pfirst = &*first;
+
+    return std::next(first, ::scanChars(pfirst, std::next(pfirst, std::distance(first, last)), c1, c2) - pfirst);
+}
+
+// vectorized count of c over buffer iterators, in place
+static int countChar(std::string::const_iterator first, std::string::const_iterator last, char c) {
+
+    if (first == last)
+        return 0;
+    const char* pfirst = &*first;
+
+    return (int) ::countChar(pfirst, std::next(pfirst, std::distance(first, last)), c);
+}
+
+// vectorized scan for the end of a name over buffer iterators
+static std::string::const_iterator scanNameEnd(std::string::const_iterator first, std::string::const_iterator last) {
+
+    if (first == last)
+        return last;
+    const char* pfirst = &*first;
+
+    return std::next(first, ::scanNameEnd(pfirst, std::next(pfirst, std::distance(first, last))) - pfirst);
+}
 
 // XML parsing is at a XML declaration
 bool isXMLDeclaration(std::string::const_iterator pc){
@@ -70,23 +111,21 @@ bool isXMLCharacters(std::string::const_iterator pc){
 }
 
 // XML parsing is at namespaces
-bool isXMLNamespace(bool intag, std::string::const_iterator pc){
-    
-    std::advance(pc, XMLNS_SIZE);
+bool isXMLNamespace(std::string& buffer, bool intag, std::string::const_iterator pc){
     
     return intag && *pc != '>' && *pc != '/' && std::distance(pc, buffer.cend()) > (int) XMLNS_SIZE && std::string(pc, std::next(pc, XMLNS_SIZE)) == "xmlns"
     && (*std::next(pc, XMLNS_SIZE) == ':' || *std::next(pc, XMLNS_SIZE) == '=');
 }
 
 // Parse a XML declaration
-std::string::const_iterator parseDeclaration(std::string::const_iterator pc, std::string::const_iterator endpc, long& total){
+std::string::const_iterator parseDeclaration(std::string& buffer, InputSource& input, std::string::const_iterator pc, std::string::const_iterator endpc, long& total){
 
     //check for incomplete XML declaration
     //endpc = std::find(pc, buffer.cend(), '>');
     if (endpc == buffer.cend()) {
         //refill the buffer
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::find(pc, buffer.cend(), '>');
+        pc = refillBuffer(pc, buffer, total, input);
+        endpc = scanChar(pc, buffer.cend(), '>');
         if (endpc == buffer.cend()) {
             std::cerr << "parser error: Incomplete XML declaration\n";
             exit(1);
@@ -104,7 +143,7 @@ std::string::const_iterator parseRequiredVersion(std::string::const_iterator pc,
             std::cerr << "parser error: Missing space after before version in XML declaration\n";
             exit(1);
             }
-        std::string::const_iterator pnameend = std::find(pc, endpc, '=');
+        std::string::const_iterator pnameend = scanChar(pc, endpc, '=');
         const std::string attr(pc, pnameend);
         pc = pnameend;
         std::advance(pc, 1);
@@ -114,7 +153,7 @@ std::string::const_iterator parseRequiredVersion(std::string::const_iterator pc,
             exit(1);
             }
             std::advance(pc, 1);
-        std::string::const_iterator pvalueend = std::find(pc, endpc, delim);
+        std::string::const_iterator pvalueend = scanChar(pc, endpc, delim);
         if (pvalueend == endpc) {
             std::cerr << "parser error: Invalid end delimiter for version in XML declaration\n";
             exit(1);
@@ -137,7 +176,7 @@ std::string::const_iterator parseEncoding(std::string::const_iterator pc, std::s
             std::cerr << "parser error: Missing required encoding in XML declaration\n";
             exit(1);
         }
-        pnameend = std::find(pc, endpc, '=');
+        pnameend = scanChar(pc, endpc, '=');
         if (pnameend == endpc) {
             std::cerr << "parser error: Incomple encoding in XML declaration\n";
             exit(1);
@@ -151,7 +190,7 @@ std::string::const_iterator parseEncoding(std::string::const_iterator pc, std::s
             exit(1);
         }
         std::advance(pc, 1);
-        pvalueend = std::find(pc, endpc, delim2);
+        pvalueend = scanChar(pc, endpc, delim2);
         if (pvalueend == endpc) {
             std::cerr << "parser error: Incomple encoding in XML declaration\n";
             exit(1);
@@ -168,13 +207,13 @@ std::string::const_iterator parseEncoding(std::string::const_iterator pc, std::s
     }
 
 // Parse a XML standalone
-std::string::const_iterator parseStandalone(std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
+std::string::const_iterator parseStandalone(std::string& buffer, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
 
         if (pc == endpc) {
             std::cerr << "parser error: Missing required third attribute standalone in XML declaration\n";
             exit(1);
         }
-        pnameend = std::find(pc, endpc, '=');
+        pnameend = scanChar(pc, endpc, '=');
         const std::string attr3(pc, pnameend);
         pc = pnameend;
         std::advance(pc, 1);
@@ -184,7 +223,7 @@ std::string::const_iterator parseStandalone(std::string::const_iterator pc, std:
             exit(1);
         }
         std::advance(pc, 1);
-        pvalueend = std::find(pc, endpc, delim3);
+        pvalueend = scanChar(pc, endpc, delim3);
         if (pvalueend == endpc) {
             std::cerr << "parser error : Missing attribute standalone in XML declaration\n";
             exit(1);
@@ -203,20 +242,20 @@ std::string::const_iterator parseStandalone(std::string::const_iterator pc, std:
 }
 
 // Parse a XML end tag
-std::string::const_iterator parseEndTag(std::string::const_iterator pc, std::string::const_iterator pvalueend, int depth, long& total){
+std::string::const_iterator parseEndTag(std::string& buffer, InputSource& input, std::string::const_iterator pc, std::string::const_iterator pvalueend, int depth, long& total){
 
         --depth;
-    std::string::const_iterator endpc = std::find(pc, buffer.cend(), '>');
+    std::string::const_iterator endpc = scanChar(pc, buffer.cend(), '>');
         if (endpc == buffer.cend()) {
-            pc = refillBuffer(pc, buffer, total);
-            endpc = std::find(pc, buffer.cend(), '>');
+            pc = refillBuffer(pc, buffer, total, input);
+            endpc = scanChar(pc, buffer.cend(), '>');
             if (endpc == buffer.cend()) {
                 std::cerr << "parser error: Incomplete element end tag\n";
                 exit(1);
             }
         }
         std::advance(pc, 2);
-    std::string::const_iterator pnameend = std::find_if(pc, std::next(endpc), [] (char c) { return isspace(c) || c == '>' || c == '/'; });
+    std::string::const_iterator pnameend = scanNameEnd(pc, std::next(endpc));
         if (pnameend == std::next(endpc)) {
               std::cerr << "parser error: Incomplete element end tag name\n";
               exit(1);
@@ -239,19 +278,19 @@ std::string::const_iterator parseEndTag(std::string::const_iterator pc, std::str
 }
 
 // Parse a XML start tag
-std::string::const_iterator parseStartTag(int depth, long& total, bool intag, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend, const std::string local_name){
+std::string::const_iterator parseStartTag(std::string& buffer, InputSource& input, int depth, long& total, bool intag, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend, const std::string local_name){
 
-        endpc = std::find(pc, buffer.cend(), '>');
+        endpc = scanChar(pc, buffer.cend(), '>');
         if (endpc == buffer.cend()) {
-            pc = refillBuffer(pc, buffer, total);
-            endpc = std::find(pc, buffer.cend(), '>');
+            pc = refillBuffer(pc, buffer, total, input);
+            endpc = scanChar(pc, buffer.cend(), '>');
             if (endpc == buffer.cend()) {
                 std::cerr << "parser error: Incomplete element start tag\n";
                 exit(1);
             }
         }
         std::advance(pc, 1);
-        pnameend = std::find_if(pc, std::next(endpc), [] (char c) { return isspace(c) || c == '>' || c == '/'; });
+        pnameend = scanNameEnd(pc, std::next(endpc));
         if (pnameend == std::next(endpc)) {
             std::cerr << "parser error : Unterminated start tag '" << std::string(pc, pnameend) << "'\n";
             exit(1);
@@ -286,10 +325,10 @@ std::string::const_iterator parseStartTag(int depth, long& total, bool intag, st
     }
 
 // Parse a XML namespace
-std::string::const_iterator parseNameSpace(bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
+std::string::const_iterator parseNameSpace(std::string& buffer, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
 
-        endpc = std::find(pc, buffer.cend(), '>');
-        pnameend = std::find(pc, std::next(endpc), '=');
+        endpc = scanChar(pc, buffer.cend(), '>');
+        pnameend = scanChar(pc, std::next(endpc), '=');
         if (pnameend == std::next(endpc)) {
             std::cerr << "parser error : incomplete namespace\n";
             exit(1);
@@ -312,7 +351,7 @@ std::string::const_iterator parseNameSpace(bool intag, std::string::const_iterat
             exit(1);
             }
         std::advance(pc, 1);
-        pvalueend = std::find(pc, std::next(endpc), delim);
+        pvalueend = scanChar(pc, std::next(endpc), delim);
         if (pvalueend == std::next(endpc)) {
             std::cerr << "parser error : incomplete namespace\n";
             exit(1);
@@ -333,10 +372,10 @@ std::string::const_iterator parseNameSpace(bool intag, std::string::const_iterat
 }
 
 // Parse a XML attribute
-std::string::const_iterator parseAttribute(std::string url, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
+std::string::const_iterator parseAttribute(std::string& buffer, std::string url, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend){
     
-    endpc = std::find(pc, buffer.cend(), '>');
-    pnameend = std::find(pc, std::next(endpc), '=');
+    endpc = scanChar(pc, buffer.cend(), '>');
+    pnameend = scanChar(pc, std::next(endpc), '=');
     if (pnameend == std::next(endpc))
         exit(1);
     const std::string qname(pc, pnameend);
@@ -363,7 +402,7 @@ std::string::const_iterator parseAttribute(std::string url, bool intag, std::str
         exit(1);
     }
     std::advance(pc, 1);
-    pvalueend = std::find(pc, std::next(endpc), delim);
+    pvalueend = scanChar(pc, std::next(endpc), delim);
     if (pvalueend == std::next(endpc)) {
         std::cerr << "parser error : attribute " << qname << " missing delimiter\n";
         exit(1);
@@ -385,38 +424,53 @@ std::string::const_iterator parseAttribute(std::string url, bool intag, std::str
     return pc;
 }
 
-// Parse a XML CDATA
-std::string::const_iterator parseCDATA(std::string::const_iterator pc,  std::string::const_iterator endpc, int loc, int textsize, long& total){
+// Parse a XML CDATA, passing over content larger than the buffer in chunks
+std::string::const_iterator parseCDATA(std::string& buffer, InputSource& input, std::string::const_iterator pc,  std::string::const_iterator endpc, int loc, int textsize, long& total){
     
     const std::string endcdata = "]]>";
+    if (std::distance(pc, buffer.cend()) < (int) strlen("<![CDATA[")) {
+        pc = refillBuffer(pc, buffer, total, input);
+        if (pc == buffer.cend()) {
+            std::cerr << "parser error : Unterminated CDATA\n";
+            exit(1);
+        }
+    }
     std::advance(pc, strlen("<![CDATA["));
     endpc = std::search(pc, buffer.cend(), endcdata.begin(), endcdata.end());
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
+    while (endpc == buffer.cend()) {
+        // all but what may be the start of "]]>" is counted, and the buffer refilled
+        const std::string::const_iterator pchunkend = std::prev(buffer.cend(), std::min<std::ptrdiff_t>((std::ptrdiff_t) endcdata.size() - 1, std::distance(pc, buffer.cend())));
+        textsize += (int) std::distance(pc, pchunkend);
+        loc += countChar(pc, pchunkend, '\n');
+        pc = refillBuffer(pchunkend, buffer, total, input);
+        if (pc == buffer.cend()) {
+            std::cerr << "parser error : Unterminated CDATA\n";
+            exit(1);
+        }
         endpc = std::search(pc, buffer.cend(), endcdata.begin(), endcdata.end());
-        if (endpc == buffer.cend())
-           exit(1);
     }
-    const std::string characters(pc, endpc);
-    textsize += (int) characters.size();
-    loc += (int) std::count(characters.begin(), characters.end(), '\n');
+    textsize += (int) std::distance(pc, endpc);
+    loc += countChar(pc, endpc, '\n');
     pc = std::next(endpc, strlen("]]>"));
     
     return pc;
 }
 
-// Parse a XML comment
-std::string::const_iterator parseComment(std::string::const_iterator pc,  std::string::const_iterator endpc, long& total){
+// Parse a XML comment, passing over content larger than the buffer in chunks
+std::string::const_iterator parseComment(std::string& buffer, InputSource& input, std::string::const_iterator pc,  std::string::const_iterator endpc, long& total){
 
     const std::string endcomment = "-->";
+    std::advance(pc, strlen("<!--"));
     endpc = std::search(pc, buffer.cend(), endcomment.begin(), endcomment.end());
-    if (endpc == buffer.cend()) {
-        pc = refillBuffer(pc, buffer, total);
-        endpc = std::search(pc, buffer.cend(), endcomment.begin(), endcomment.end());
-        if (endpc == buffer.cend()) {
+    while (endpc == buffer.cend()) {
+        // all but what may be the start of "-->" is passed over, and the buffer refilled
+        const std::string::const_iterator pchunkend = std::prev(buffer.cend(), std::min<std::ptrdiff_t>((std::ptrdiff_t) endcomment.size() - 1, std::distance(pc, buffer.cend())));
+        pc = refillBuffer(pchunkend, buffer, total, input);
+        if (pc == buffer.cend()) {
             std::cerr << "parser error : Unterminated XML comment\n";
             exit(1);
         }
+        endpc = std::search(pc, buffer.cend(), endcomment.begin(), endcomment.end());
     }
     pc = std::next(endpc, strlen("-->"));
     pc = std::find_if_not(pc, buffer.cend(), [] (char c) { return isspace(c); });
@@ -425,10 +479,10 @@ std::string::const_iterator parseComment(std::string::const_iterator pc,  std::s
 }
 
 // Parse a XML character before or after XML
-std::string::const_iterator parseCharactersBeforeOrAfter(std::string::const_iterator pc){
+std::string::const_iterator parseCharactersBeforeOrAfter(std::string& buffer, std::string::const_iterator pc){
     
     pc = std::find_if_not(pc, buffer.cend(), [] (char c) { return isspace(c); });
-    if (pc == buffer.cend() || !isspace(*pc)) {
+    if (pc != buffer.cend() && *pc != '<') {
         std::cerr << "parser error : Start tag expected, '<' not found\n";
         exit(1);
     }
@@ -436,53 +490,41 @@ std::string::const_iterator parseCharactersBeforeOrAfter(std::string::const_iter
 }
 
 // Parse a XML entity references
-std::string::const_iterator parseEntityReference(std::string::const_iterator pc, int textsize, long& total){
-
-    std::string characters;
-    if (std::distance(pc, buffer.cend()) < 3) {
-        pc = refillBuffer(pc, buffer, total);
-        if (std::distance(pc, buffer.cend()) < 3) {
-            std::cerr << "parser error : Incomplete entity reference, '" << std::string(pc, buffer.cend()) << "'\n";
+std::string::const_iterator parseEntityReference(std::string& buffer, InputSource& input, std::string::const_iterator pc, int textsize, long& total){
+
+    char characters[ENTITY_MAX_CHARACTERS];
+    const char* end;
+    int size;
+    EntityResult result = decodeEntity(&*pc, buffer.data() + buffer.size(), characters, end, size);
+    // a refill may add fewer characters than the rest of the reference, e.g., from a pipe
+    while (result == ENTITY_INCOMPLETE) {
+        const auto leftover = std::distance(pc, buffer.cend());
+        pc = refillBuffer(pc, buffer, total, input);
+        if (pc == buffer.cend()) {
+            // at the end of input, the rest of the reference was moved to the start of the buffer
+            std::cerr << "parser error : Incomplete entity reference, '" << std::string(buffer.cbegin(), std::next(buffer.cbegin(), leftover)) << "'\n";
             exit(1);
         }
+        result = decodeEntity(&*pc, buffer.data() + buffer.size(), characters, end, size);
     }
-    if (*std::next(pc) == 'l' && *std::next(pc, 2) == 't' && *std::next(pc, 3) == ';') {
-        characters += '<';
-        std::advance(pc, strlen("&lt;"));
-    } else if (*std::next(pc) == 'g' && *std::next(pc, 2) == 't' && *std::next(pc, 3) == ';') {
-        characters += '>';
-        std::advance(pc, strlen("&gt;"));
-    } else if (*std::next(pc) == 'a' && *std::next(pc, 2) == 'm' && *std::next(pc, 3) == 'p') {
-        if (std::distance(pc, buffer.cend()) < 4) {
-            pc = refillBuffer(pc, buffer, total);
-            if (std::distance(pc, buffer.cend()) < 4) {
-                std::cerr << "parser error : Incomplete entity reference, '" << std::string(pc, buffer.cend()) << "'\n";
-                exit(1);
-            }
-        }
-        if (*std::next(pc, 4) != ';') {
-            const std::string partialEntity(pc, std::next(pc, 4));
-            std::cerr << "parser error : Incomplete entity reference, '" << partialEntity << "'\n";
-            exit(1);
-        }
-        characters += '&';
-        std::advance(pc, strlen("&amp;"));
+    if (result == ENTITY_DECODED) {
+        textsize += size;
+        std::advance(pc, end - &*pc);
     } else {
-        characters += '&';
+        // not a reference, so the '&' is characters
+        textsize += 1;
         std::advance(pc, 1);
     }
-    textsize += (int) characters.size();
     
     return pc;
 }
 
 // Parse a XML characters
-std::string::const_iterator parseCharacters(std::string::const_iterator pc, int loc, int textsize){
+std::string::const_iterator parseCharacters(std::string& buffer, std::string::const_iterator pc, int loc, int textsize){
     
-    const std::string::const_iterator endpc = std::find_if(pc, buffer.cend(), [] (char c) { return c == '<' || c == '&'; });
-    const std::string characters(pc, endpc);
-    loc += (int) std::count(characters.cbegin(), characters.cend(), '\n');
-    textsize += (int) characters.size();
+    const std::string::const_iterator endpc = scanChars(pc, buffer.cend(), '<', '&');
+    loc += countChar(pc, endpc, '\n');
+    textsize += (int) std::distance(pc, endpc);
     pc = endpc;
     
     return pc;
@@ -7,8 +7,18 @@
 #ifndef INCLUDED_XML_PARSER_HPP
 #define INCLUDED_XML_PARSER_HPP
 
+#include "InputSource.hpp"
 #include <string>
 
+/*
+    The functions parse in a buffer filled by refillBuffer(), and pc and
+    the other iterators are into it. Functions that may reach the end of
+    the buffer, or refill it, are passed the buffer. There is no global
+    state, so each parse, e.g., on its own thread, has its own buffer.
+    Functions that refill are also passed the source of the input
+    (see InputSource.hpp), e.g., standard input, a file, or a callback.
+*/
+
 // is parsing at a XML declaration
 bool isXMLDeclaration(std::string::const_iterator pc);
 
@@ -37,10 +47,10 @@ bool isXMLEntityCharacters(std::string::const_iterator pc);
 bool isXMLCharacters(std::string::const_iterator pc);
 
 // is parsing at a XML namespaces
-bool isXMLNamespace(bool intag, std::string::const_iterator pc);
+bool isXMLNamespace(std::string& buffer, bool intag, std::string::const_iterator pc);
 
 // parse declaration
-std::string::const_iterator parseDeclaration(std::string::const_iterator pc, std::string::const_iterator endpc, long& total);
+std::string::const_iterator parseDeclaration(std::string& buffer, InputSource& input, std::string::const_iterator pc, std::string::const_iterator endpc, long& total);
 
 // parse required version
 std::string::const_iterator parseRequiredVersion(std::string::const_iterator pc, std::string::const_iterator endpc);
@@ -49,33 +59,33 @@ std::string::const_iterator parseRequiredVersion(std::string::const_iterator pc,
 std::string::const_iterator parseEncoding(std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
 
 // parse a XML standalone
-std::string::const_iterator parseStandalone(std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
+std::string::const_iterator parseStandalone(std::string& buffer, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
 
 // parse a XML end tag
-std::string::const_iterator parseEndTag(std::string::const_iterator pc, std::string::const_iterator pvalueend, int depth, long& total);
+std::string::const_iterator parseEndTag(std::string& buffer, InputSource& input, std::string::const_iterator pc, std::string::const_iterator pvalueend, int depth, long& total);
 
 // parse a XML start tag
-std::string::const_iterator parseStartTag(int depth, long& total, bool intag, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend,std::string::const_iterator pvalueend, const std::string local_name);
+std::string::const_iterator parseStartTag(std::string& buffer, InputSource& input, int depth, long& total, bool intag, std::string::const_iterator pc, std::string::const_iterator endpc, std::string::const_iterator pnameend,std::string::const_iterator pvalueend, const std::string local_name);
 
 // parse a XML namespace
-std::string::const_iterator parseNameSpace(bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
+std::string::const_iterator parseNameSpace(std::string& buffer, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
 
 // parse a XML attribute
-std::string::const_iterator parseAttribute(std::string url, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
+std::string::const_iterator parseAttribute(std::string& buffer, std::string url, bool intag, std::string::const_iterator pc,  std::string::const_iterator endpc, std::string::const_iterator pnameend, std::string::const_iterator pvalueend);
 
 // parse a XML CDATA
-std::string::const_iterator parseCDATA(std::string::const_iterator pc,  std::string::const_iterator endpc, int loc, int textsize, long& total);
+std::string::const_iterator parseCDATA(std::string& buffer, InputSource& input, std::string::const_iterator pc,  std::string::const_iterator endpc, int loc, int textsize, long& total);
 
 // parse a XML comment
-std::string::const_iterator parseComment(std::string::const_iterator pc,  std::string::const_iterator endpc, long& total);
+std::string::const_iterator parseComment(std::string& buffer, InputSource& input, std::string::const_iterator pc,  std::string::const_iterator endpc, long& total);
 
 // parse a XML character before or after XML
-std::string::const_iterator parseCharactersBeforeOrAfter(std::string::const_iterator pc);
+std::string::const_iterator parseCharactersBeforeOrAfter(std::string& buffer, std::string::const_iterator pc);
 
 // parse a XML entity references
-std::string::const_iterator parseEntityReference(std::string::const_iterator pc, int textsize, long& total);
+std::string::const_iterator parseEntityReference(std::string& buffer, InputSource& input, std::string::const_iterator pc, int textsize, long& total);
 
 // parse a XML characters
-std::string::const_iterator parseCharacters(std::string::const_iterator pc, int loc, int textsize);
+std::string::const_iterator parseCharacters(std::string& buffer, std::string::const_iterator pc, int loc, int textsize);
 
 #endif